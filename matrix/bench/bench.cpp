@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "src/kernels.h"
+#include "src/matrix.h"
+#include "src/tuning.h"
+
+using task::Matrix;
+
+namespace {
+
+// Every result is the median of @samples timed batches, a batch repeats
+// the operation until it takes at least @min_batch_seconds
+constexpr size_t samples = 7;
+constexpr double min_batch_seconds = 2e-3;
+// Batches of huge sizes are single runs, sampling stops after this budget
+constexpr double max_op_seconds = 10.;
+
+const char *const known_ops[] = {"multiply", "add", "transpose", "det", "parse", "print"};
+
+struct Options {
+  size_t min_size = 8;
+  size_t max_size = 1024;
+  std::vector<std::string> ops = {known_ops, known_ops + std::size(known_ops)};
+  std::string json = "bench_output.json";
+  double threshold = 0.05;
+  std::string compare_old, compare_new;
+};
+
+struct Result {
+  std::string op;
+  size_t size = 0;
+  double ns_per_op = 0;
+  // fastest sample, less sensitive to interference than the median
+  double best_ns = 0;
+  double gflops = 0;
+  double gbps = 0;
+  // relative standard deviation of samples, used as noise estimate
+  double noise = 0;
+  size_t reps = 0;
+};
+
+struct Workload {
+  std::function<void()> run;
+  double flops;
+  double bytes;
+};
+
+volatile double sink = 0;
+
+Matrix randomMatrix(size_t dim, std::mt19937_64 &rand) {
+  std::uniform_real_distribution<double> dist{-10., 10.};
+  Matrix res(dim, dim);
+  for (size_t row = 0; row < dim; row++) {
+    for (size_t col = 0; col < dim; col++) {
+      res[row][col] = dist(rand);
+    }
+  }
+  return res;
+}
+
+double seconds(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration<double>(duration).count();
+}
+
+Result measure(const std::string &op, size_t dim, const Workload &work) {
+  using clock = std::chrono::steady_clock;
+  // warm up and calibrate the batch length
+  auto start = clock::now();
+  work.run();
+  const double once = std::max(seconds(clock::now() - start), 1e-9);
+  const size_t batch = std::max<size_t>(1, static_cast<size_t>(min_batch_seconds / once));
+
+  std::vector<double> times;
+  double total = 0;
+  while (times.size() < samples && (times.empty() || total < max_op_seconds)) {
+    start = clock::now();
+    for (size_t i = 0; i < batch; i++)
+      work.run();
+    const double elapsed = seconds(clock::now() - start);
+    times.push_back(elapsed / batch);
+    total += elapsed;
+  }
+
+  std::vector<double> sorted = times;
+  std::sort(sorted.begin(), sorted.end());
+  const double median = sorted[sorted.size() / 2];
+  double mean = 0, variance = 0;
+  for (double t : times)
+    mean += t / times.size();
+  for (double t : times)
+    variance += (t - mean) * (t - mean) / times.size();
+
+  Result res;
+  res.op = op;
+  res.size = dim;
+  res.ns_per_op = median * 1e9;
+  res.best_ns = sorted.front() * 1e9;
+  res.gflops = work.flops / median * 1e-9;
+  res.gbps = work.bytes / median * 1e-9;
+  res.noise = mean > 0 ? std::sqrt(variance) / mean : 0;
+  res.reps = batch * times.size();
+  return res;
+}
+
+// Bytes are the compulsory traffic: operands read once, result written once.
+// For parse and print it is the text length
+Workload workload(const std::string &op, const Matrix &lhs, const Matrix &rhs,
+                  const std::string &text) {
+  const double dim = static_cast<double>(lhs.getRows());
+  const double cells = dim * dim * sizeof(double);
+  if (op == "multiply")
+    return {[&] { sink = sink + (lhs * rhs)[0][0]; }, 2. * dim * dim * dim, 3. * cells};
+  if (op == "add")
+    return {[&] { sink = sink + (lhs + rhs)[0][0]; }, dim * dim, 3. * cells};
+  if (op == "transpose")
+    return {[&] { sink = sink + lhs.transposed()[0][0]; }, 0., 2. * cells};
+  if (op == "det")
+    return {[&] { sink = sink + lhs.det(); }, 2. / 3. * dim * dim * dim, 2. * cells};
+  if (op == "parse") {
+    return {[&] {
+              std::istringstream input(text);
+              Matrix res;
+              input >> res;
+              sink = sink + res[0][0];
+            },
+            0., static_cast<double>(text.size())};
+  }
+  if (op == "print") {
+    return {[&] {
+              std::ostringstream output;
+              output << lhs;
+              sink = sink + output.tellp();
+            },
+            0., static_cast<double>(text.size())};
+  }
+  throw std::invalid_argument("unknown operation " + op);
+}
+
+void writeJson(const std::string &path, const std::vector<Result> &results) {
+  std::ofstream output(path, std::ios::trunc);
+  output << "{\n  \"isa\": \"" << task::kernels::active().name << "\",\n  \"results\": [\n";
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result &res = results[i];
+    output << "    {\"op\": \"" << res.op << "\", \"size\": " << res.size
+           << ", \"ns_per_op\": " << res.ns_per_op << ", \"best_ns\": " << res.best_ns
+           << ", \"gflops\": " << res.gflops
+           << ", \"gbps\": " << res.gbps << ", \"noise\": " << res.noise
+           << ", \"reps\": " << res.reps << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+  output << "  ]\n}\n";
+}
+
+// Reads files written by writeJson(), one result object per line
+std::vector<Result> readJson(const std::string &path) {
+  std::ifstream input(path);
+  if (!input)
+    throw std::runtime_error("cannot open " + path);
+  auto field = [](const std::string &line, const std::string &key) {
+    const size_t pos = line.find("\"" + key + "\": ");
+    return pos == std::string::npos ? std::string() : line.substr(pos + key.size() + 4);
+  };
+  std::vector<Result> results;
+  std::string line;
+  while (std::getline(input, line)) {
+    const std::string op = field(line, "op");
+    if (op.empty())
+      continue;
+    Result res;
+    res.op = op.substr(1, op.find('"', 1) - 1);
+    res.size = std::stoul(field(line, "size"));
+    res.ns_per_op = std::stod(field(line, "ns_per_op"));
+    res.best_ns = std::stod(field(line, "best_ns"));
+    res.noise = std::stod(field(line, "noise"));
+    results.push_back(res);
+  }
+  return results;
+}
+
+// Runs are compared by their fastest samples. A result regresses when it is
+// slower by more than the threshold, or by more than twice the noise
+// measured in either run if that is larger
+int compare(const Options &options) {
+  const std::vector<Result> old_results = readJson(options.compare_old);
+  const std::vector<Result> new_results = readJson(options.compare_new);
+  std::map<std::pair<std::string, size_t>, Result> baseline;
+  for (const Result &res : old_results)
+    baseline[{res.op, res.size}] = res;
+
+  size_t regressions = 0;
+  std::cout << std::left << std::setw(10) << "op" << std::right << std::setw(6) << "size"
+            << std::setw(14) << "old best ns" << std::setw(14) << "new best ns" << std::setw(10)
+            << "change" << "\n";
+  for (const Result &res : new_results) {
+    auto found = baseline.find({res.op, res.size});
+    if (found == baseline.end())
+      continue;
+    const Result &old = found->second;
+    const double change = res.best_ns / old.best_ns - 1.;
+    const double limit = std::max(options.threshold, 2. * std::max(old.noise, res.noise));
+    const char *verdict = change > limit ? "  REGRESSION" : change < -limit ? "  faster" : "";
+    regressions += change > limit;
+    std::cout << std::left << std::setw(10) << res.op << std::right << std::setw(6) << res.size
+              << std::fixed << std::setprecision(1) << std::setw(14) << old.best_ns
+              << std::setw(14) << res.best_ns << std::setw(9) << change * 100. << "%"
+              << verdict << "\n";
+  }
+  std::cout << regressions << " regression(s)\n";
+  return regressions > 0 ? 1 : 0;
+}
+
+std::vector<std::string> split(const std::string &list) {
+  std::vector<std::string> res;
+  std::istringstream input(list);
+  std::string item;
+  while (std::getline(input, item, ','))
+    res.push_back(item);
+  return res;
+}
+
+void run(const Options &options) {
+  for (const std::string &op : options.ops) {
+    if (std::find(std::begin(known_ops), std::end(known_ops), op) == std::end(known_ops))
+      throw std::invalid_argument("unknown operation " + op);
+  }
+  // block sizes are loaded (or tuned, with MATRIX_TUNE_CACHE set) up front,
+  // not inside the first sample
+  task::tuning::blockSizes();
+  std::mt19937_64 rand(42);
+  std::vector<Result> results;
+  std::cout << "kernels: " << task::kernels::active().name << "\n"
+            << std::left << std::setw(10) << "op" << std::right << std::setw(6) << "size"
+            << std::setw(16) << "ns/op" << std::setw(10) << "GFLOP/s" << std::setw(10)
+            << "GB/s" << std::setw(8) << "noise" << "\n";
+  for (size_t dim = std::max<size_t>(1, options.min_size); dim <= options.max_size; dim *= 2) {
+    const Matrix lhs = randomMatrix(dim, rand);
+    const Matrix rhs = randomMatrix(dim, rand);
+    std::ostringstream printed;
+    printed << dim << " " << dim << "\n" << lhs;
+    const std::string text = printed.str();
+
+    for (const std::string &op : options.ops) {
+      const Result res = measure(op, dim, workload(op, lhs, rhs, text));
+      results.push_back(res);
+      std::cout << std::left << std::setw(10) << res.op << std::right << std::setw(6)
+                << res.size << std::fixed << std::setprecision(1) << std::setw(16)
+                << res.ns_per_op << std::setprecision(2) << std::setw(10) << res.gflops
+                << std::setw(10) << res.gbps << std::setw(7) << res.noise * 100. << "%"
+                << std::endl;
+    }
+  }
+  writeJson(options.json, results);
+  std::cout << "results written to " << options.json << "\n";
+}
+
+void usage() {
+  std::cout << "usage: matrix_bench [--min-size N] [--max-size N] [--ops a,b,...] [--json PATH]\n"
+               "       matrix_bench --compare OLD.json NEW.json [--threshold FRACTION]\n"
+               "ops: multiply, add, transpose, det, parse, print\n";
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (arg == "--min-size" && has_value) {
+      options.min_size = std::stoul(argv[++i]);
+    } else if (arg == "--max-size" && has_value) {
+      options.max_size = std::stoul(argv[++i]);
+    } else if (arg == "--ops" && has_value) {
+      options.ops = split(argv[++i]);
+    } else if (arg == "--json" && has_value) {
+      options.json = argv[++i];
+    } else if (arg == "--threshold" && has_value) {
+      options.threshold = std::stod(argv[++i]);
+    } else if (arg == "--compare" && i + 2 < argc) {
+      options.compare_old = argv[++i];
+      options.compare_new = argv[++i];
+    } else {
+      usage();
+      return arg == "--help" ? 0 : 2;
+    }
+  }
+  try {
+    if (!options.compare_old.empty())
+      return compare(options);
+    run(options);
+  } catch (const std::exception &error) {
+    std::cerr << "matrix_bench: " << error.what() << "\n";
+    return 2;
+  }
+  return 0;
+}
@@ -0,0 +1,415 @@
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+#include "eigen.h"
+
+using namespace task;
+
+namespace {
+
+// Jacobi spreads work over threads only from this size on
+constexpr size_t min_parallel_dim = 96;
+
+// Reusable barrier for a fixed team of threads
+class Barrier {
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  const size_t m_count;
+  size_t m_waiting = 0;
+  size_t m_generation = 0;
+
+public:
+  explicit Barrier(size_t count) : m_count(count) {}
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    const size_t generation = m_generation;
+    if (++m_waiting == m_count) {
+      m_waiting = 0;
+      m_generation++;
+      m_cv.notify_all();
+      return;
+    }
+    m_cv.wait(lock, [this, generation] { return generation != m_generation; });
+  }
+};
+
+// Symmetric copy of @matrix built from its lower triangle, row-major
+std::vector<double> denseSymmetric(const Matrix &matrix) {
+  const size_t dim = matrix.getRows();
+  std::vector<double> a(dim * dim);
+  for (size_t row = 0; row < dim; row++) {
+    for (size_t col = 0; col <= row; col++) {
+      a[row * dim + col] = a[col * dim + row] = matrix[row][col];
+    }
+  }
+  return a;
+}
+
+double offDiagonalNorm(const std::vector<double> &a, size_t dim) {
+  double sum = 0;
+  for (size_t row = 0; row < dim; row++) {
+    for (size_t col = 0; col < dim; col++) {
+      if (row != col)
+        sum += a[row * dim + col] * a[row * dim + col];
+    }
+  }
+  return std::sqrt(sum);
+}
+
+// Sort eigenpairs by ascending eigenvalue, @v is row-major, vectors in columns
+void finish(EigenResult &result, const std::vector<double> &d,
+            const std::vector<double> &v, size_t dim) {
+  std::vector<size_t> order(dim);
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&d](size_t lhs, size_t rhs) { return d[lhs] < d[rhs]; });
+  result.values.resize(dim);
+  result.vectors = Matrix(dim, dim, 0., 0.);
+  for (size_t k = 0; k < dim; k++) {
+    result.values[k] = d[order[k]];
+    for (size_t row = 0; row < dim; row++) {
+      result.vectors[row][k] = v[row * dim + order[k]];
+    }
+  }
+}
+
+struct Rotation {
+  size_t p = 0;
+  size_t q = 0;
+  double c = 1;
+  double s = 0;
+  bool active = false;
+};
+
+// Cyclic Jacobi. Each sweep is split into m - 1 rounds of a round-robin
+// tournament (m = n rounded up to even), every round pairs all indices into
+// m / 2 disjoint (p, q) pairs. Rotations of one round commute, so they are
+// computed together and applied as A = J^T A J in two parallel phases:
+// columns p, q of every row (threads own row ranges), then rows p, q
+// (threads own pairs)
+EigenResult jacobi(const Matrix &matrix, const EigenOptions &options) {
+  const size_t dim = matrix.getRows();
+  std::vector<double> a = denseSymmetric(matrix);
+  std::vector<double> v(dim * dim, 0.);
+  for (size_t i = 0; i < dim; i++)
+    v[i * dim + i] = 1.;
+
+  double norm = 0;
+  for (double x : a)
+    norm += x * x;
+  norm = std::sqrt(norm);
+
+  EigenResult result;
+  result.off_norm = offDiagonalNorm(a, dim);
+  result.converged = result.off_norm <= options.tolerance * norm;
+
+  const size_t m = dim + dim % 2;
+  const size_t pair_count = m / 2;
+  size_t thread_count = options.threads > 0 ? options.threads
+                                            : std::max(1u, std::thread::hardware_concurrency());
+  if (dim < min_parallel_dim)
+    thread_count = 1;
+  thread_count = std::min(thread_count, std::max<size_t>(1, pair_count));
+
+  std::vector<Rotation> rotations(pair_count);
+  Barrier barrier(thread_count);
+  bool done = result.converged || dim < 2;
+
+  // index at position @pos of round @round, position 0 is fixed
+  auto player = [m](size_t round, size_t pos) {
+    return pos == 0 ? 0 : 1 + (pos - 1 + round) % (m - 1);
+  };
+
+  auto worker = [&](size_t t) {
+    const size_t row_begin = dim * t / thread_count;
+    const size_t row_end = dim * (t + 1) / thread_count;
+    while (!done) {
+      for (size_t round = 0; round + 1 < m; round++) {
+        // rotations zeroing a_pq, skipping the dummy index of odd n
+        for (size_t i = t; i < pair_count; i += thread_count) {
+          Rotation &rot = rotations[i];
+          rot.p = std::min(player(round, i), player(round, m - 1 - i));
+          rot.q = std::max(player(round, i), player(round, m - 1 - i));
+          rot.active = false;
+          if (rot.q >= dim)
+            continue;
+          const double apq = a[rot.p * dim + rot.q];
+          if (apq == 0.)
+            continue;
+          const double tau = (a[rot.q * dim + rot.q] - a[rot.p * dim + rot.p]) / (2. * apq);
+          const double tan = (tau >= 0 ? 1. : -1.) / (fabs(tau) + std::sqrt(1. + tau * tau));
+          rot.c = 1. / std::sqrt(1. + tan * tan);
+          rot.s = tan * rot.c;
+          rot.active = true;
+        }
+        barrier.wait();
+
+        // A = A * J, V = V * J
+        for (size_t k = row_begin; k < row_end; k++) {
+          double *a_k = a.data() + k * dim;
+          double *v_k = v.data() + k * dim;
+          for (const Rotation &rot : rotations) {
+            if (!rot.active)
+              continue;
+            const double akp = a_k[rot.p], akq = a_k[rot.q];
+            a_k[rot.p] = rot.c * akp - rot.s * akq;
+            a_k[rot.q] = rot.s * akp + rot.c * akq;
+            const double vkp = v_k[rot.p], vkq = v_k[rot.q];
+            v_k[rot.p] = rot.c * vkp - rot.s * vkq;
+            v_k[rot.q] = rot.s * vkp + rot.c * vkq;
+          }
+        }
+        barrier.wait();
+
+        // A = J^T * A
+        for (size_t i = t; i < pair_count; i += thread_count) {
+          const Rotation &rot = rotations[i];
+          if (!rot.active)
+            continue;
+          double *a_p = a.data() + rot.p * dim;
+          double *a_q = a.data() + rot.q * dim;
+          for (size_t k = 0; k < dim; k++) {
+            const double apk = a_p[k], aqk = a_q[k];
+            a_p[k] = rot.c * apk - rot.s * aqk;
+            a_q[k] = rot.s * apk + rot.c * aqk;
+          }
+          a_p[rot.q] = a_q[rot.p] = 0.;
+        }
+        barrier.wait();
+      }
+
+      if (t == 0) {
+        result.sweeps++;
+        result.off_norm = offDiagonalNorm(a, dim);
+        result.converged = result.off_norm <= options.tolerance * norm;
+        done = result.converged || result.sweeps >= options.max_sweeps;
+      }
+      barrier.wait();
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < thread_count; t++)
+    threads.emplace_back(worker, t);
+  worker(0);
+  for (auto &thread : threads)
+    thread.join();
+
+  std::vector<double> d(dim);
+  for (size_t i = 0; i < dim; i++)
+    d[i] = a[i * dim + i];
+  finish(result, d, v, dim);
+  return result;
+}
+
+// Householder reduction of symmetric @v to tridiagonal form (diagonal @d,
+// subdiagonal @e), @v is replaced by the accumulated orthogonal transform.
+// Follows EISPACK tred2
+void tridiagonalize(std::vector<double> &v, std::vector<double> &d,
+                    std::vector<double> &e, long n) {
+  auto V = [&v, n](long row, long col) -> double & { return v[row * n + col]; };
+  for (long j = 0; j < n; j++)
+    d[j] = V(n - 1, j);
+
+  for (long i = n - 1; i > 0; i--) {
+    double scale = 0., h = 0.;
+    for (long k = 0; k < i; k++)
+      scale += fabs(d[k]);
+    if (scale == 0.) {
+      e[i] = d[i - 1];
+      for (long j = 0; j < i; j++) {
+        d[j] = V(i - 1, j);
+        V(i, j) = 0.;
+        V(j, i) = 0.;
+      }
+    } else {
+      // generate Householder vector
+      for (long k = 0; k < i; k++) {
+        d[k] /= scale;
+        h += d[k] * d[k];
+      }
+      double f = d[i - 1];
+      double g = std::sqrt(h);
+      if (f > 0)
+        g = -g;
+      e[i] = scale * g;
+      h -= f * g;
+      d[i - 1] = f - g;
+      for (long j = 0; j < i; j++)
+        e[j] = 0.;
+
+      // apply similarity transformation to remaining columns
+      for (long j = 0; j < i; j++) {
+        f = d[j];
+        V(j, i) = f;
+        g = e[j] + V(j, j) * f;
+        for (long k = j + 1; k <= i - 1; k++) {
+          g += V(k, j) * d[k];
+          e[k] += V(k, j) * f;
+        }
+        e[j] = g;
+      }
+      f = 0.;
+      for (long j = 0; j < i; j++) {
+        e[j] /= h;
+        f += e[j] * d[j];
+      }
+      const double hh = f / (h + h);
+      for (long j = 0; j < i; j++)
+        e[j] -= hh * d[j];
+      for (long j = 0; j < i; j++) {
+        f = d[j];
+        g = e[j];
+        for (long k = j; k <= i - 1; k++)
+          V(k, j) -= (f * e[k] + g * d[k]);
+        d[j] = V(i - 1, j);
+        V(i, j) = 0.;
+      }
+    }
+    d[i] = h;
+  }
+
+  // accumulate transformations
+  for (long i = 0; i < n - 1; i++) {
+    V(n - 1, i) = V(i, i);
+    V(i, i) = 1.;
+    const double h = d[i + 1];
+    if (h != 0.) {
+      for (long k = 0; k <= i; k++)
+        d[k] = V(k, i + 1) / h;
+      for (long j = 0; j <= i; j++) {
+        double g = 0.;
+        for (long k = 0; k <= i; k++)
+          g += V(k, i + 1) * V(k, j);
+        for (long k = 0; k <= i; k++)
+          V(k, j) -= g * d[k];
+      }
+    }
+    for (long k = 0; k <= i; k++)
+      V(k, i + 1) = 0.;
+  }
+  for (long j = 0; j < n; j++) {
+    d[j] = V(n - 1, j);
+    V(n - 1, j) = 0.;
+  }
+  V(n - 1, n - 1) = 1.;
+  e[0] = 0.;
+}
+
+// Implicit QL iterations on tridiagonal (@d, @e), rotations are
+// accumulated into @v. Follows EISPACK tql2, returns iteration count
+size_t tridiagonalQL(std::vector<double> &v, std::vector<double> &d,
+                     std::vector<double> &e, long n, size_t max_iterations,
+                     bool &converged) {
+  auto V = [&v, n](long row, long col) -> double & { return v[row * n + col]; };
+  for (long i = 1; i < n; i++)
+    e[i - 1] = e[i];
+  e[n - 1] = 0.;
+
+  const double eps = std::numeric_limits<double>::epsilon();
+  double f = 0., tst1 = 0.;
+  size_t iterations = 0;
+  converged = true;
+  for (long l = 0; l < n; l++) {
+    // find small subdiagonal element
+    tst1 = std::max(tst1, fabs(d[l]) + fabs(e[l]));
+    long m = l;
+    while (m < n - 1 && fabs(e[m]) > eps * tst1)
+      m++;
+
+    if (m > l) {
+      do {
+        if (iterations++ >= max_iterations) {
+          converged = false;
+          return iterations;
+        }
+        // compute implicit shift
+        double g = d[l];
+        double p = (d[l + 1] - g) / (2. * e[l]);
+        double r = std::hypot(p, 1.);
+        if (p < 0)
+          r = -r;
+        d[l] = e[l] / (p + r);
+        d[l + 1] = e[l] * (p + r);
+        const double dl1 = d[l + 1];
+        double h = g - d[l];
+        for (long i = l + 2; i < n; i++)
+          d[i] -= h;
+        f += h;
+
+        // implicit QL transformation
+        p = d[m];
+        double c = 1., c2 = c, c3 = c;
+        const double el1 = e[l + 1];
+        double s = 0., s2 = 0.;
+        for (long i = m - 1; i >= l; i--) {
+          c3 = c2;
+          c2 = c;
+          s2 = s;
+          g = c * e[i];
+          h = c * p;
+          r = std::hypot(p, e[i]);
+          e[i + 1] = s * r;
+          s = e[i] / r;
+          c = p / r;
+          p = c * d[i] - s * g;
+          d[i + 1] = h + s * (c * g + s * d[i]);
+          for (long k = 0; k < n; k++) {
+            h = V(k, i + 1);
+            V(k, i + 1) = s * V(k, i) + c * h;
+            V(k, i) = c * V(k, i) - s * h;
+          }
+        }
+        p = -s * s2 * c3 * el1 * e[l] / dl1;
+        e[l] = s * p;
+        d[l] = c * p;
+      } while (fabs(e[l]) > eps * tst1);
+    }
+    d[l] += f;
+    e[l] = 0.;
+  }
+  return iterations;
+}
+
+EigenResult tridiagonal(const Matrix &matrix, const EigenOptions &options) {
+  const size_t dim = matrix.getRows();
+  EigenResult result;
+  std::vector<double> v = denseSymmetric(matrix);
+  std::vector<double> d(dim, 0.), e(dim, 0.);
+  if (dim > 0) {
+    tridiagonalize(v, d, e, static_cast<long>(dim));
+    // QL needs a few iterations per eigenvalue, sweeps bound them per row
+    result.sweeps = tridiagonalQL(v, d, e, static_cast<long>(dim),
+                                  options.max_sweeps * dim, result.converged);
+  } else {
+    result.converged = true;
+  }
+  double off = 0;
+  for (double x : e)
+    off += 2. * x * x;
+  result.off_norm = std::sqrt(off);
+  finish(result, d, v, dim);
+  return result;
+}
+
+}  // namespace
+
+EigenResult task::symmetricEigen(const Matrix &matrix, const EigenOptions &options) {
+  if (matrix.getRows() != matrix.getCols())
+    throw SizeMismatchException{};
+  EigenMethod method = options.method;
+  if (method == EigenMethod::Auto) {
+    method = matrix.getRows() >= options.tridiagonal_threshold ? EigenMethod::Tridiagonal
+                                                               : EigenMethod::Jacobi;
+  }
+  return method == EigenMethod::Jacobi ? jacobi(matrix, options) : tridiagonal(matrix, options);
+}
+
+EigenResult task::symmetricEigen(const SymmetricMatrix &matrix, const EigenOptions &options) {
+  return symmetricEigen(matrix.toMatrix(), options);
+}
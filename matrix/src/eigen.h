@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vector>
+
+#include "matrix.h"
+#include "structured_matrix.h"
+
+
+namespace task {
+
+enum class EigenMethod {
+  Auto,        // Jacobi below tridiagonal_threshold, Tridiagonal otherwise
+  Jacobi,      // cyclic Jacobi rotations, parallel round-robin ordering
+  Tridiagonal  // Householder reduction to tridiagonal form + implicit QL
+};
+
+struct EigenOptions {
+  EigenMethod method = EigenMethod::Auto;
+  size_t tridiagonal_threshold = 128;
+  // Jacobi stops when off-diagonal norm <= tolerance * ||A||_F
+  double tolerance = 1.e-14;
+  size_t max_sweeps = 64;
+  // Jacobi worker threads, 0 means hardware concurrency,
+  // small matrices are always handled by one thread
+  size_t threads = 0;
+};
+
+struct EigenResult {
+  // ascending eigenvalues
+  std::vector<double> values;
+  // column i is the unit eigenvector of values[i]
+  Matrix vectors;
+  // Jacobi sweeps or QL iterations performed
+  size_t sweeps = 0;
+  // Frobenius norm of the off-diagonal part left at exit
+  double off_norm = 0;
+  bool converged = false;
+};
+
+// Eigen decomposition of a symmetric matrix, only the lower triangle
+// of @matrix is read. Throws SizeMismatchException for non-square input
+EigenResult symmetricEigen(const Matrix &matrix, const EigenOptions &options = {});
+EigenResult symmetricEigen(const SymmetricMatrix &matrix, const EigenOptions &options = {});
+
+}  // namespace task
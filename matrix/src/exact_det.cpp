@@ -0,0 +1,408 @@
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <thread>
+
+#include "exact_det.h"
+
+using namespace task;
+
+namespace {
+
+using u64 = uint64_t;
+using u128 = unsigned __int128;
+
+/////////////////////////// Modular helpers
+
+u64 mulMod(u64 a, u64 b, u64 p) {
+  return static_cast<u64>(static_cast<u128>(a) * b % p);
+}
+
+u64 powMod(u64 base, u64 exp, u64 p) {
+  u64 res = 1 % p;
+  base %= p;
+  while (exp > 0) {
+    if (exp & 1)
+      res = mulMod(res, base, p);
+    base = mulMod(base, base, p);
+    exp >>= 1;
+  }
+  return res;
+}
+
+// Deterministic Miller-Rabin for 64-bit numbers
+bool isPrime(u64 n) {
+  if (n < 2)
+    return false;
+  static constexpr u64 bases[] = {2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37};
+  for (u64 b : bases) {
+    if (n % b == 0)
+      return n == b;
+  }
+  u64 d = n - 1;
+  size_t s = 0;
+  while ((d & 1) == 0) {
+    d >>= 1;
+    s++;
+  }
+  for (u64 b : bases) {
+    u64 x = powMod(b, d, n);
+    if (x == 1 || x == n - 1)
+      continue;
+    bool composite = true;
+    for (size_t r = 1; r < s && composite; r++) {
+      x = mulMod(x, x, n);
+      composite = x != n - 1;
+    }
+    if (composite)
+      return false;
+  }
+  return true;
+}
+
+// First @count primes below 2^62, computed once and shared between calls
+std::vector<u64> primes(size_t count) {
+  static std::mutex mutex;
+  static std::vector<u64> cache;
+  std::lock_guard<std::mutex> lock(mutex);
+  u64 candidate = cache.empty() ? (u64(1) << 62) - 1 : cache.back() - 2;
+  while (cache.size() < count) {
+    if (isPrime(candidate))
+      cache.push_back(candidate);
+    candidate -= 2;
+  }
+  return std::vector<u64>(cache.begin(), cache.begin() + count);
+}
+
+// Montgomery arithmetic modulo odd p < 2^62, R = 2^64
+class Montgomery {
+  u64 m_p;
+  u64 m_p_inv;  // -p^{-1} mod R
+  u64 m_r2;     // R^2 mod p
+
+public:
+  explicit Montgomery(u64 p) : m_p(p), m_p_inv(0), m_r2(0) {
+    // Newton iteration for p^{-1} mod 2^64
+    u64 inv = p;
+    for (int i = 0; i < 6; i++)
+      inv *= 2 - p * inv;
+    m_p_inv = -inv;
+    const u64 r = (0 - p) % p;
+    m_r2 = mulMod(r, r, p);
+  }
+
+  u64 reduce(u128 t) const {
+    const u64 m = static_cast<u64>(t) * m_p_inv;
+    const u64 u = static_cast<u64>((t + static_cast<u128>(m) * m_p) >> 64);
+    return u >= m_p ? u - m_p : u;
+  }
+
+  u64 mul(u64 a, u64 b) const { return reduce(static_cast<u128>(a) * b); }
+  u64 sub(u64 a, u64 b) const { return a >= b ? a - b : a + m_p - b; }
+  u64 to(u64 a) const { return mul(a % m_p, m_r2); }
+  u64 from(u64 a) const { return reduce(a); }
+
+  u64 pow(u64 base, u64 exp) const {
+    u64 res = to(1);
+    while (exp > 0) {
+      if (exp & 1)
+        res = mul(res, base);
+      base = mul(base, base);
+      exp >>= 1;
+    }
+    return res;
+  }
+};
+
+// det(a) mod p by Gaussian elimination, @a holds entries reduced mod p
+u64 detMod(std::vector<u64> a, size_t dim, u64 p) {
+  const Montgomery mont(p);
+  for (u64 &x : a)
+    x = mont.to(x);
+
+  u64 det = mont.to(1);
+  bool negative = false;
+  for (size_t k = 0; k < dim; k++) {
+    size_t pivot_row = k;
+    while (pivot_row < dim && a[pivot_row * dim + k] == 0)
+      pivot_row++;
+    if (pivot_row == dim)
+      return 0;
+    if (pivot_row != k) {
+      std::swap_ranges(a.begin() + k * dim, a.begin() + (k + 1) * dim,
+                       a.begin() + pivot_row * dim);
+      negative = !negative;
+    }
+
+    const u64 *row_k = a.data() + k * dim;
+    det = mont.mul(det, row_k[k]);
+    const u64 pivot_inv = mont.pow(row_k[k], p - 2);
+    for (size_t i = k + 1; i < dim; i++) {
+      u64 *row_i = a.data() + i * dim;
+      if (row_i[k] == 0)
+        continue;
+      const u64 factor = mont.mul(row_i[k], pivot_inv);
+      for (size_t j = k + 1; j < dim; j++) {
+        row_i[j] = mont.sub(row_i[j], mont.mul(factor, row_k[j]));
+      }
+    }
+  }
+  det = mont.from(det);
+  return negative && det != 0 ? p - det : det;
+}
+
+}  // namespace
+
+/////////////////////////// Big integer implementation
+
+BigInteger::BigInteger(int64_t value)
+  : m_negative(value < 0)
+{
+  u64 magnitude = value < 0 ? u64(0) - static_cast<u64>(value) : static_cast<u64>(value);
+  while (magnitude > 0) {
+    m_limbs.push_back(static_cast<uint32_t>(magnitude));
+    magnitude >>= 32;
+  }
+}
+
+void BigInteger::trim() {
+  while (!m_limbs.empty() && m_limbs.back() == 0)
+    m_limbs.pop_back();
+  if (m_limbs.empty())
+    m_negative = false;
+}
+
+void BigInteger::mulAdd(uint64_t mul, uint64_t add) {
+  u128 carry = add;
+  for (uint32_t &limb : m_limbs) {
+    carry += static_cast<u128>(limb) * mul;
+    limb = static_cast<uint32_t>(carry);
+    carry >>= 32;
+  }
+  while (carry > 0) {
+    m_limbs.push_back(static_cast<uint32_t>(carry));
+    carry >>= 32;
+  }
+  trim();
+}
+
+int BigInteger::compareMagnitude(const BigInteger &lhs, const BigInteger &rhs) {
+  if (lhs.m_limbs.size() != rhs.m_limbs.size())
+    return lhs.m_limbs.size() < rhs.m_limbs.size() ? -1 : 1;
+  for (size_t i = lhs.m_limbs.size(); i-- > 0;) {
+    if (lhs.m_limbs[i] != rhs.m_limbs[i])
+      return lhs.m_limbs[i] < rhs.m_limbs[i] ? -1 : 1;
+  }
+  return 0;
+}
+
+BigInteger BigInteger::addMagnitude(const BigInteger &lhs, const BigInteger &rhs) {
+  const BigInteger &longer = lhs.m_limbs.size() >= rhs.m_limbs.size() ? lhs : rhs;
+  const BigInteger &shorter = &longer == &lhs ? rhs : lhs;
+  BigInteger res = longer;
+  res.m_negative = false;
+  u64 carry = 0;
+  for (size_t i = 0; i < res.m_limbs.size(); i++) {
+    carry += static_cast<u64>(res.m_limbs[i]) +
+             (i < shorter.m_limbs.size() ? shorter.m_limbs[i] : 0);
+    res.m_limbs[i] = static_cast<uint32_t>(carry);
+    carry >>= 32;
+  }
+  if (carry > 0)
+    res.m_limbs.push_back(static_cast<uint32_t>(carry));
+  return res;
+}
+
+BigInteger BigInteger::subtractMagnitude(const BigInteger &lhs, const BigInteger &rhs) {
+  BigInteger res = lhs;
+  res.m_negative = false;
+  int64_t borrow = 0;
+  for (size_t i = 0; i < res.m_limbs.size(); i++) {
+    int64_t diff = static_cast<int64_t>(res.m_limbs[i]) - borrow -
+                   (i < rhs.m_limbs.size() ? rhs.m_limbs[i] : 0);
+    borrow = diff < 0;
+    res.m_limbs[i] = static_cast<uint32_t>(diff + (borrow << 32));
+  }
+  res.trim();
+  return res;
+}
+
+BigInteger BigInteger::operator-() const {
+  BigInteger res = *this;
+  if (!res.isZero())
+    res.m_negative = !res.m_negative;
+  return res;
+}
+
+bool BigInteger::operator==(const BigInteger &rhs) const {
+  return m_negative == rhs.m_negative && m_limbs == rhs.m_limbs;
+}
+
+bool BigInteger::operator!=(const BigInteger &rhs) const {
+  return !(*this == rhs);
+}
+
+bool BigInteger::operator<(const BigInteger &rhs) const {
+  if (m_negative != rhs.m_negative)
+    return m_negative;
+  const int cmp = compareMagnitude(*this, rhs);
+  return m_negative ? cmp > 0 : cmp < 0;
+}
+
+BigInteger BigInteger::operator+(const BigInteger &rhs) const {
+  if (m_negative == rhs.m_negative) {
+    BigInteger res = addMagnitude(*this, rhs);
+    res.m_negative = m_negative;
+    res.trim();
+    return res;
+  }
+  // signs differ: subtract smaller magnitude from larger one
+  if (compareMagnitude(*this, rhs) >= 0) {
+    BigInteger res = subtractMagnitude(*this, rhs);
+    res.m_negative = m_negative;
+    res.trim();
+    return res;
+  }
+  BigInteger res = subtractMagnitude(rhs, *this);
+  res.m_negative = rhs.m_negative;
+  res.trim();
+  return res;
+}
+
+BigInteger BigInteger::operator-(const BigInteger &rhs) const {
+  return *this + -rhs;
+}
+
+bool BigInteger::isZero() const {
+  return m_limbs.empty();
+}
+
+bool BigInteger::isNegative() const {
+  return m_negative;
+}
+
+bool BigInteger::fitsInt128() const {
+  return m_limbs.size() < 4 || (m_limbs.size() == 4 && (m_limbs[3] >> 31) == 0);
+}
+
+__int128 BigInteger::toInt128() const {
+  u128 magnitude = 0;
+  for (size_t i = std::min<size_t>(m_limbs.size(), 4); i-- > 0;) {
+    magnitude = (magnitude << 32) | m_limbs[i];
+  }
+  const __int128 value = static_cast<__int128>(magnitude);
+  return m_negative ? -value : value;
+}
+
+std::string BigInteger::toString() const {
+  if (isZero())
+    return "0";
+  // repeated division by 10^9
+  constexpr uint32_t base = 1000000000;
+  std::vector<uint32_t> limbs = m_limbs;
+  std::string digits;
+  while (!limbs.empty()) {
+    u64 remainder = 0;
+    for (size_t i = limbs.size(); i-- > 0;) {
+      const u64 cur = (remainder << 32) | limbs[i];
+      limbs[i] = static_cast<uint32_t>(cur / base);
+      remainder = cur % base;
+    }
+    while (!limbs.empty() && limbs.back() == 0)
+      limbs.pop_back();
+    for (int d = 0; d < 9; d++) {
+      digits.push_back(static_cast<char>('0' + remainder % 10));
+      remainder /= 10;
+      if (limbs.empty() && remainder == 0)
+        break;
+    }
+  }
+  if (m_negative)
+    digits.push_back('-');
+  std::reverse(digits.begin(), digits.end());
+  return digits;
+}
+
+std::ostream &task::operator<<(std::ostream &output, const BigInteger &value) {
+  return output << value.toString();
+}
+
+/////////////////////////// Exact determinant
+
+BigInteger task::detExact(const Matrix &matrix) {
+  if (matrix.getRows() != matrix.getCols())
+    throw SizeMismatchException{};
+  const size_t dim = matrix.getRows();
+  constexpr double int64_limit = 9223372036854775808.;
+
+  // Hadamard bound: |det| <= prod_i ||row_i||
+  std::vector<int64_t> entries(dim * dim);
+  double log2_bound = 0;
+  for (size_t row = 0; row < dim; row++) {
+    double norm2 = 0;
+    for (size_t col = 0; col < dim; col++) {
+      const double value = matrix[row][col];
+      if (value != std::floor(value) || fabs(value) >= int64_limit)
+        throw NonIntegerMatrixException{};
+      entries[row * dim + col] = static_cast<int64_t>(value);
+      norm2 += value * value;
+    }
+    if (norm2 == 0.)
+      return BigInteger(0);
+    log2_bound += 0.5 * std::log2(norm2);
+  }
+
+  // product of primes must exceed 2 * bound to recover the sign,
+  // every prime is above 2^61, one spare prime covers rounding of the bound
+  const size_t prime_count = static_cast<size_t>(std::ceil((log2_bound + 1) / 61)) + 1;
+  const std::vector<u64> moduli = primes(prime_count);
+
+  std::vector<u64> residues(prime_count);
+  const size_t thread_count = std::min<size_t>(
+      prime_count, std::max(1u, std::thread::hardware_concurrency()));
+  auto worker = [&](size_t first) {
+    std::vector<u64> reduced(entries.size());
+    for (size_t k = first; k < prime_count; k += thread_count) {
+      const u64 p = moduli[k];
+      const int64_t signed_p = static_cast<int64_t>(p);
+      for (size_t i = 0; i < entries.size(); i++) {
+        const int64_t r = entries[i] % signed_p;
+        reduced[i] = static_cast<u64>(r < 0 ? r + signed_p : r);
+      }
+      residues[k] = detMod(reduced, dim, p);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < thread_count; t++)
+    threads.emplace_back(worker, t);
+  worker(0);
+  for (auto &thread : threads)
+    thread.join();
+
+  // Garner: x = v_0 + p_0 * (v_1 + p_1 * (v_2 + ...))
+  std::vector<u64> digits(prime_count);
+  for (size_t k = 0; k < prime_count; k++) {
+    const u64 p = moduli[k];
+    u64 value = residues[k];
+    for (size_t j = 0; j < k; j++) {
+      const u64 diff = (value + p - digits[j] % p) % p;
+      value = mulMod(diff, powMod(moduli[j] % p, p - 2, p), p);
+    }
+    digits[k] = value;
+  }
+
+  BigInteger value(0), modulus(1);
+  for (size_t k = prime_count; k-- > 0;) {
+    value.mulAdd(moduli[k], 0);
+    value.mulAdd(1, digits[k]);
+  }
+  for (u64 p : moduli)
+    modulus.mulAdd(p, 0);
+
+  // symmetric range: values above modulus / 2 are negative
+  BigInteger twice = value;
+  twice.mulAdd(2, 0);
+  if (modulus < twice)
+    return value - modulus;
+  return value;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "matrix.h"
+
+
+namespace task {
+
+class NonIntegerMatrixException : public std::exception {};
+
+// Minimal arbitrary precision integer, enough to hold exact determinants
+class BigInteger {
+private:
+  bool m_negative = false;
+  // magnitude, little-endian base 2^32, no leading zero limbs
+  std::vector<uint32_t> m_limbs;
+
+private:
+  void trim();
+  // Compare magnitudes, returns -1, 0 or 1
+  static int compareMagnitude(const BigInteger &lhs, const BigInteger &rhs);
+  // |lhs| + |rhs|
+  static BigInteger addMagnitude(const BigInteger &lhs, const BigInteger &rhs);
+  // |lhs| - |rhs|, requires |lhs| >= |rhs|
+  static BigInteger subtractMagnitude(const BigInteger &lhs, const BigInteger &rhs);
+
+public:
+  BigInteger(int64_t value = 0);
+
+  // |x| = |x| * mul + add
+  void mulAdd(uint64_t mul, uint64_t add);
+
+  BigInteger operator-() const;
+  BigInteger operator+(const BigInteger &rhs) const;
+  BigInteger operator-(const BigInteger &rhs) const;
+
+  bool operator==(const BigInteger &rhs) const;
+  bool operator!=(const BigInteger &rhs) const;
+  bool operator<(const BigInteger &rhs) const;
+
+  bool isZero() const;
+  bool isNegative() const;
+  bool fitsInt128() const;
+  __int128 toInt128() const;
+  std::string toString() const;
+};
+
+std::ostream &operator<<(std::ostream &output, const BigInteger &value);
+
+// Exact determinant of a square matrix with integer entries (|a_ij| < 2^63).
+// Eliminates modulo as many 62-bit primes as the Hadamard bound requires,
+// one thread per prime (up to hardware concurrency), and reconstructs
+// the signed result by Chinese Remainder Theorem (Garner's algorithm).
+// Throws NonIntegerMatrixException if some entry is not an integer
+BigInteger detExact(const Matrix &matrix);
+
+}  // namespace task
@@ -0,0 +1,255 @@
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TASK_KERNELS_X86 1
+#endif
+
+#include "kernels.h"
+
+using namespace task::kernels;
+
+namespace {
+
+/////////////////////////// Generic kernels
+
+void axpyGeneric(size_t n, double alpha, const double *x, double *y) {
+  for (size_t i = 0; i < n; i++)
+    y[i] += alpha * x[i];
+}
+
+void addGeneric(size_t n, const double *x, double *y) {
+  for (size_t i = 0; i < n; i++)
+    y[i] += x[i];
+}
+
+void subGeneric(size_t n, const double *x, double *y) {
+  for (size_t i = 0; i < n; i++)
+    y[i] -= x[i];
+}
+
+void scaleGeneric(size_t n, double alpha, double *y) {
+  for (size_t i = 0; i < n; i++)
+    y[i] *= alpha;
+}
+
+const KernelTable generic_table = {Isa::Generic, "generic", axpyGeneric,
+                                   addGeneric, subGeneric, scaleGeneric};
+
+#ifdef TASK_KERNELS_X86
+
+/////////////////////////// SSE4.2 kernels, 2 lanes
+
+__attribute__((target("sse4.2")))
+void axpySse42(size_t n, double alpha, const double *x, double *y) {
+  const __m128d a = _mm_set1_pd(alpha);
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2) {
+    __m128d r = _mm_add_pd(_mm_loadu_pd(y + i), _mm_mul_pd(a, _mm_loadu_pd(x + i)));
+    _mm_storeu_pd(y + i, r);
+  }
+  for (; i < n; i++)
+    y[i] += alpha * x[i];
+}
+
+__attribute__((target("sse4.2")))
+void addSse42(size_t n, const double *x, double *y) {
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2)
+    _mm_storeu_pd(y + i, _mm_add_pd(_mm_loadu_pd(y + i), _mm_loadu_pd(x + i)));
+  for (; i < n; i++)
+    y[i] += x[i];
+}
+
+__attribute__((target("sse4.2")))
+void subSse42(size_t n, const double *x, double *y) {
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2)
+    _mm_storeu_pd(y + i, _mm_sub_pd(_mm_loadu_pd(y + i), _mm_loadu_pd(x + i)));
+  for (; i < n; i++)
+    y[i] -= x[i];
+}
+
+__attribute__((target("sse4.2")))
+void scaleSse42(size_t n, double alpha, double *y) {
+  const __m128d a = _mm_set1_pd(alpha);
+  size_t i = 0;
+  for (; i + 2 <= n; i += 2)
+    _mm_storeu_pd(y + i, _mm_mul_pd(a, _mm_loadu_pd(y + i)));
+  for (; i < n; i++)
+    y[i] *= alpha;
+}
+
+const KernelTable sse42_table = {Isa::Sse42, "sse4.2", axpySse42,
+                                 addSse42, subSse42, scaleSse42};
+
+/////////////////////////// AVX2 + FMA kernels, 4 lanes
+
+__attribute__((target("avx2,fma")))
+void axpyAvx2(size_t n, double alpha, const double *x, double *y) {
+  const __m256d a = _mm256_set1_pd(alpha);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m256d r = _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i));
+    _mm256_storeu_pd(y + i, r);
+  }
+  for (; i < n; i++)
+    y[i] += alpha * x[i];
+}
+
+__attribute__((target("avx2,fma")))
+void addAvx2(size_t n, const double *x, double *y) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+    _mm256_storeu_pd(y + i, _mm256_add_pd(_mm256_loadu_pd(y + i), _mm256_loadu_pd(x + i)));
+  for (; i < n; i++)
+    y[i] += x[i];
+}
+
+__attribute__((target("avx2,fma")))
+void subAvx2(size_t n, const double *x, double *y) {
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+    _mm256_storeu_pd(y + i, _mm256_sub_pd(_mm256_loadu_pd(y + i), _mm256_loadu_pd(x + i)));
+  for (; i < n; i++)
+    y[i] -= x[i];
+}
+
+__attribute__((target("avx2,fma")))
+void scaleAvx2(size_t n, double alpha, double *y) {
+  const __m256d a = _mm256_set1_pd(alpha);
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+    _mm256_storeu_pd(y + i, _mm256_mul_pd(a, _mm256_loadu_pd(y + i)));
+  for (; i < n; i++)
+    y[i] *= alpha;
+}
+
+const KernelTable avx2_table = {Isa::Avx2, "avx2", axpyAvx2,
+                                addAvx2, subAvx2, scaleAvx2};
+
+/////////////////////////// AVX-512 kernels, 8 lanes, masked tails
+
+__attribute__((target("avx512f")))
+void axpyAvx512(size_t n, double alpha, const double *x, double *y) {
+  const __m512d a = _mm512_set1_pd(alpha);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m512d r = _mm512_fmadd_pd(a, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i));
+    _mm512_storeu_pd(y + i, r);
+  }
+  if (i < n) {
+    const __mmask8 m = static_cast<__mmask8>((1u << (n - i)) - 1);
+    __m512d r = _mm512_fmadd_pd(a, _mm512_maskz_loadu_pd(m, x + i),
+                                _mm512_maskz_loadu_pd(m, y + i));
+    _mm512_mask_storeu_pd(y + i, m, r);
+  }
+}
+
+__attribute__((target("avx512f")))
+void addAvx512(size_t n, const double *x, double *y) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+    _mm512_storeu_pd(y + i, _mm512_add_pd(_mm512_loadu_pd(y + i), _mm512_loadu_pd(x + i)));
+  if (i < n) {
+    const __mmask8 m = static_cast<__mmask8>((1u << (n - i)) - 1);
+    __m512d r = _mm512_add_pd(_mm512_maskz_loadu_pd(m, y + i), _mm512_maskz_loadu_pd(m, x + i));
+    _mm512_mask_storeu_pd(y + i, m, r);
+  }
+}
+
+__attribute__((target("avx512f")))
+void subAvx512(size_t n, const double *x, double *y) {
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+    _mm512_storeu_pd(y + i, _mm512_sub_pd(_mm512_loadu_pd(y + i), _mm512_loadu_pd(x + i)));
+  if (i < n) {
+    const __mmask8 m = static_cast<__mmask8>((1u << (n - i)) - 1);
+    __m512d r = _mm512_sub_pd(_mm512_maskz_loadu_pd(m, y + i), _mm512_maskz_loadu_pd(m, x + i));
+    _mm512_mask_storeu_pd(y + i, m, r);
+  }
+}
+
+__attribute__((target("avx512f")))
+void scaleAvx512(size_t n, double alpha, double *y) {
+  const __m512d a = _mm512_set1_pd(alpha);
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8)
+    _mm512_storeu_pd(y + i, _mm512_mul_pd(a, _mm512_loadu_pd(y + i)));
+  if (i < n) {
+    const __mmask8 m = static_cast<__mmask8>((1u << (n - i)) - 1);
+    _mm512_mask_storeu_pd(y + i, m, _mm512_mul_pd(a, _mm512_maskz_loadu_pd(m, y + i)));
+  }
+}
+
+const KernelTable avx512_table = {Isa::Avx512, "avx512", axpyAvx512,
+                                  addAvx512, subAvx512, scaleAvx512};
+
+#endif  // TASK_KERNELS_X86
+
+// Highest isa allowed by MATRIX_ISA environment variable
+Isa isaLimit() {
+  const char *limit = std::getenv("MATRIX_ISA");
+  if (!limit)
+    return Isa::Avx512;
+  if (!std::strcmp(limit, "generic"))
+    return Isa::Generic;
+  if (!std::strcmp(limit, "sse4.2"))
+    return Isa::Sse42;
+  if (!std::strcmp(limit, "avx2"))
+    return Isa::Avx2;
+  return Isa::Avx512;
+}
+
+const KernelTable &selectBest() {
+  const Isa limit = isaLimit();
+  for (Isa isa : {Isa::Avx512, Isa::Avx2, Isa::Sse42}) {
+    if (isa <= limit && supported(isa))
+      return table(isa);
+  }
+  return generic_table;
+}
+
+}  // namespace
+
+bool task::kernels::supported(Isa isa) {
+#ifdef TASK_KERNELS_X86
+  __builtin_cpu_init();
+  switch (isa) {
+    case Isa::Generic:
+      return true;
+    case Isa::Sse42:
+      return __builtin_cpu_supports("sse4.2");
+    case Isa::Avx2:
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case Isa::Avx512:
+      return __builtin_cpu_supports("avx512f");
+  }
+  return false;
+#else
+  return isa == Isa::Generic;
+#endif
+}
+
+const KernelTable &task::kernels::table(Isa isa) {
+#ifdef TASK_KERNELS_X86
+  switch (isa) {
+    case Isa::Generic:
+      return generic_table;
+    case Isa::Sse42:
+      return sse42_table;
+    case Isa::Avx2:
+      return avx2_table;
+    case Isa::Avx512:
+      return avx512_table;
+  }
+#endif
+  return generic_table;
+}
+
+const KernelTable &task::kernels::active() {
+  static const KernelTable &best = selectBest();
+  return best;
+}
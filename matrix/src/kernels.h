@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+
+
+namespace task {
+namespace kernels {
+
+// Instruction set extensions kernels are compiled for, in ascending order
+enum class Isa { Generic, Sse42, Avx2, Avx512 };
+
+// Row kernels used by Matrix arithmetic, multiplication and elimination
+struct KernelTable {
+  Isa isa;
+  const char *name;
+  // y[i] += alpha * x[i]
+  void (*axpy)(size_t n, double alpha, const double *x, double *y);
+  // y[i] += x[i]
+  void (*add)(size_t n, const double *x, double *y);
+  // y[i] -= x[i]
+  void (*sub)(size_t n, const double *x, double *y);
+  // y[i] *= alpha
+  void (*scale)(size_t n, double alpha, double *y);
+};
+
+// True if the host CPU (and the build target) can run @isa kernels
+bool supported(Isa isa);
+
+// Kernels compiled for @isa, @isa must be supported
+const KernelTable &table(Isa isa);
+
+// Best supported kernels, chosen once by CPUID on first call.
+// MATRIX_ISA=generic|sse4.2|avx2|avx512 environment variable caps the choice
+const KernelTable &active();
+
+}  // namespace kernels
+}  // namespace task
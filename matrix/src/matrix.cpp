@@ -1,7 +1,12 @@
 #include <algorithm>
 #include <cmath>
+#include <memory>
+#include <numeric>
+#include <thread>
 
+#include "kernels.h"
 #include "matrix.h"
+#include "tuning.h"
 
 using namespace task;
 
@@ -37,6 +42,11 @@ Row::~Row() {
   clear();
 }
 
+void Row::swap(Row &rhs) noexcept {
+  std::swap(m_size, rhs.m_size);
+  std::swap(m_row, rhs.m_row);
+}
+
 void Row::clear() {
   if (m_size > 0) {
     delete[] m_row;
@@ -55,6 +65,18 @@ const double &Row::operator[](size_t col) const {
   return const_cast<Row *>(this)->operator[](col);
 }
 
+double *Row::data() {
+  return m_row;
+}
+
+const double *Row::data() const {
+  return m_row;
+}
+
+size_t Row::size() const {
+  return m_size;
+}
+
 /////////////////////////// Row view implementation
 
 RowView::RowView(Row &row)
@@ -69,75 +91,143 @@ double &RowView::operator[](size_t col) {
 const double &RowView::operator[](size_t col) const {
   return m_row->operator[](col);
 }
+
+double *RowView::data() {
+  return m_row->data();
+}
+
+const double *RowView::data() const {
+  return m_row->data();
+}
+
+/////////////////////////// Const row view implementation
+
+ConstRowView::ConstRowView(const Row &row)
+  : m_row(&row)
+{
+}
+
+const double &ConstRowView::operator[](size_t col) const {
+  return m_row->operator[](col);
+}
+
+const double *ConstRowView::data() const {
+  return m_row->data();
+}
 /////////////////////////// Matrix implementation
+namespace {
+
+// inverse() uses one thread below this size
+constexpr size_t min_parallel_dim = 128;
+
+// Deep copy of @count rows, nothing is leaked if a row allocation throws
+std::unique_ptr<Row[]> copyRows(const Row *rows, size_t count) {
+  std::unique_ptr<Row[]> copy(new Row[count]);
+  for (size_t r = 0; r < count; r++) {
+    copy[r] = rows[r];
+  }
+  return copy;
+}
+
+// Maximum absolute column sum
+double oneNorm(const Matrix &matrix) {
+  std::vector<double> sums(matrix.getCols(), 0.);
+  for (size_t row = 0; row < matrix.getRows(); row++) {
+    const double *values = matrix[row].data();
+    for (size_t col = 0; col < sums.size(); col++)
+      sums[col] += fabs(values[col]);
+  }
+  return sums.empty() ? 0. : *std::max_element(sums.begin(), sums.end());
+}
+
+// Solves L * U * X = B for columns [begin, end) of X in place, B is given
+// in @x, @lu holds unit lower L and U packed as factorizeLU() leaves them
+void substitute(const std::vector<const double *> &lu, const std::vector<double *> &x,
+                size_t begin, size_t end) {
+  const auto &row_kernels = kernels::active();
+  const size_t dim = lu.size();
+  const size_t width = end - begin;
+  for (size_t i = 1; i < dim; i++) {
+    for (size_t k = 0; k < i; k++) {
+      if (lu[i][k] != 0.)
+        row_kernels.axpy(width, -lu[i][k], x[k] + begin, x[i] + begin);
+    }
+  }
+  for (size_t i = dim; i-- > 0;) {
+    for (size_t k = i + 1; k < dim; k++) {
+      if (lu[i][k] != 0.)
+        row_kernels.axpy(width, -lu[i][k], x[k] + begin, x[i] + begin);
+    }
+    row_kernels.scale(width, 1. / lu[i][i], x[i] + begin);
+  }
+}
+
+}  // namespace
+
 
 Matrix::Matrix()
   : m_rows(default_size)
   , m_cols(default_size)
-  , m_data(m_rows > 0 ? new Row[m_rows] : nullptr)
 {
-  for (size_t r = 0; r < m_rows; r++) {
-    m_data[r] = Row(m_cols);
-  }
+  allocate();
   initialize(diag_default, off_diag_default);
 }
 
 Matrix::Matrix(size_t rows, size_t cols, double diag_value, double off_diag_value)
     : m_rows(rows)
     , m_cols(cols)
-    , m_data(m_rows > 0 ? new Row[m_rows] : nullptr)
 {
-  for (size_t r = 0; r < m_rows; r++) {
-    m_data[r] = Row(m_cols);
-  }
+  allocate();
   initialize(diag_value, off_diag_value);
 }
 
 Matrix::Matrix(const Matrix &rhs)
   : m_rows(rhs.m_rows)
   , m_cols(rhs.m_cols)
-  , m_data(m_rows > 0 ? new Row[m_rows] : nullptr)
+  , m_copy_on_write(rhs.m_copy_on_write)
 {
-  for (size_t r = 0; r < m_rows; r++) {
-    if (m_cols > 0) {
-      m_data[r] = rhs.m_data[r];
-    }
+  if (!rhs.m_data)
+    return;
+  if (m_copy_on_write) {
+    m_data = rhs.m_data;
+    m_refs = rhs.m_refs;
+    ++*m_refs;
+    return;
   }
+  std::unique_ptr<Row[]> copy = copyRows(rhs.m_data, m_rows);
+  m_refs = new std::atomic<size_t>(1);
+  m_data = copy.release();
 }
 
 Matrix::Matrix(Matrix &&rhs) noexcept
   : m_rows(rhs.m_rows)
   , m_cols(rhs.m_cols)
   , m_data(rhs.m_data)
+  , m_refs(rhs.m_refs)
+  , m_copy_on_write(rhs.m_copy_on_write)
 {
   rhs.m_rows = 0;
   rhs.m_cols = 0;
   rhs.m_data = nullptr;
+  rhs.m_refs = nullptr;
 }
 
 Matrix &Matrix::operator=(const Matrix &rhs) {
   if (this != &rhs) {
-    clear();
-    m_rows = rhs.m_rows;
-    m_cols = rhs.m_cols;
-    if (m_rows > 0) {
-      m_data = new Row[m_rows];
-      for (size_t r = 0; r < m_rows; r++) {
-        if (m_cols > 0) {
-          m_data[r] = rhs.m_data[r];
-        }
-      }
-    }
+    Matrix copy(rhs);
+    *this = std::move(copy);
   }
   return *this;
 }
 
+// The mode is a property of the target, it is not taken from @rhs
 Matrix &Matrix::operator=(Matrix &&rhs) noexcept {
   if (this != &rhs) {
     clear();
     std::swap(m_rows, rhs.m_rows);
     std::swap(m_cols, rhs.m_cols);
     std::swap(m_data, rhs.m_data);
+    std::swap(m_refs, rhs.m_refs);
   }
   return *this;
 }
@@ -146,17 +236,44 @@ Matrix::~Matrix() {
   clear();
 }
 
-void Matrix::clear() {
-  if (m_data) {
+void Matrix::allocate() {
+  if (m_rows > 0) {
+    m_data = new Row[m_rows];
+    m_refs = new std::atomic<size_t>(1);
     for (size_t r = 0; r < m_rows; r++) {
-      m_data[r].~Row();
+      m_data[r] = Row(m_cols);
     }
+  }
+}
+
+void Matrix::clear() {
+  if (m_data && --*m_refs == 0) {
     delete[] m_data;
-    m_data = nullptr;
+    delete m_refs;
   }
+  m_data = nullptr;
+  m_refs = nullptr;
   m_rows = m_cols = 0;
 }
 
+void Matrix::detach() {
+  if (!m_refs || *m_refs == 1)
+    return;
+  // the copy is complete before it replaces the shared buffer, so a failed
+  // allocation leaves the matrix sharing its old data
+  std::unique_ptr<Row[]> copy = copyRows(m_data, m_rows);
+  std::unique_ptr<std::atomic<size_t>> copy_refs(new std::atomic<size_t>(1));
+  Row *shared = m_data;
+  std::atomic<size_t> *shared_refs = m_refs;
+  m_data = copy.release();
+  m_refs = copy_refs.release();
+  // the other owners may have released the data meanwhile
+  if (--*shared_refs == 0) {
+    delete[] shared;
+    delete shared_refs;
+  }
+}
+
 void Matrix::initialize(double diag_value, double off_diag_value) {
   for (size_t r = 0; r < m_rows; r++) {
     for (size_t c = 0; c < m_cols; c++) {
@@ -180,18 +297,22 @@ void Matrix::set(size_t row, size_t col, const double& value) {
 RowView Matrix::operator[](size_t row) {
   if (row >= m_rows)
     throw OutOfBoundsException{};
+  detach();
   return RowView(m_data[row]);
 }
 
-const RowView Matrix::operator[](size_t row) const {
-  return const_cast<Matrix *>(this)->operator[](row);
+// Read access must not detach, so it does not go through the non-const one
+ConstRowView Matrix::operator[](size_t row) const {
+  if (row >= m_rows)
+    throw OutOfBoundsException{};
+  return ConstRowView(m_data[row]);
 }
 
 void Matrix::resize(size_t new_rows, size_t new_cols) {
   Matrix that = Matrix(new_rows, new_cols, off_diag_default, off_diag_default);
   for (size_t r = 0; r < std::min(m_rows, that.m_rows); r++) {
     for (size_t c = 0; c < std::min(m_cols, that.m_cols); c++) {
-      that[r][c] = get(r, c);
+      that.m_data[r].data()[c] = m_data[r].data()[c];
     }
   }
   *this = std::move(that);
@@ -232,18 +353,22 @@ std::vector<double> Matrix::getColumn(size_t col) const {
 Matrix &Matrix::operator+=(const Matrix &rhs) {
   if (m_rows != rhs.m_rows || m_cols != rhs.m_cols)
     throw SizeMismatchException{};
-  transform([&rhs](Matrix &lhs, size_t row, size_t col) {
-    lhs[row][col] += rhs[row][col];
-  });
+  detach();
+  const auto &row_kernels = kernels::active();
+  for (size_t row = 0; row < m_rows; row++) {
+    row_kernels.add(m_cols, rhs.m_data[row].data(), m_data[row].data());
+  }
   return *this;
 }
 
 Matrix &Matrix::operator-=(const Matrix &rhs) {
   if (m_rows != rhs.m_rows || m_cols != rhs.m_cols)
     throw SizeMismatchException{};
-  transform([&rhs](Matrix &lhs, size_t row, size_t col) {
-    lhs[row][col] -= rhs[row][col];
-  });
+  detach();
+  const auto &row_kernels = kernels::active();
+  for (size_t row = 0; row < m_rows; row++) {
+    row_kernels.sub(m_cols, rhs.m_data[row].data(), m_data[row].data());
+  }
   return *this;
 }
 Matrix &Matrix::operator*=(const Matrix &rhs) {
@@ -252,9 +377,11 @@ Matrix &Matrix::operator*=(const Matrix &rhs) {
 }
 
 Matrix &Matrix::operator*=(const double &number) {
-  transform([number](Matrix &lhs, size_t row, size_t col) {
-    lhs[row][col] *= number;
-  });
+  detach();
+  const auto &row_kernels = kernels::active();
+  for (size_t row = 0; row < m_rows; row++) {
+    row_kernels.scale(m_cols, number, m_data[row].data());
+  }
   return *this;
 }
 
@@ -262,9 +389,7 @@ Matrix Matrix::operator+(const Matrix &rhs) const {
   if (m_rows != rhs.m_rows || m_cols != rhs.m_cols)
     throw SizeMismatchException{};
   Matrix res = *this;
-  res.transform([&rhs](Matrix &lhs, size_t row, size_t col) {
-    lhs[row][col] += rhs[row][col];
-  });
+  res += rhs;
   return res;
 }
 
@@ -272,35 +397,42 @@ Matrix Matrix::operator-(const Matrix &rhs) const {
   if (m_rows != rhs.m_rows || m_cols != rhs.m_cols)
     throw SizeMismatchException{};
   Matrix res = *this;
-  res.transform([&rhs](Matrix &lhs, size_t row, size_t col) {
-    lhs[row][col] -= rhs[row][col];
-  });
+  res -= rhs;
   return res;
 }
 
 // Returns A[n x m] * B[m * k] = C[n x k],
-// where C[i][j] = sum_{s} (A[i][s] x B[s][j])
+// where C[i][j] = sum_{s} (A[i][s] x B[s][j]),
+// computed row by row as C[i] += A[i][s] * B[s] to stream over rows of B,
+// loops are tiled so that tiles of A, B and C stay in cache
 Matrix Matrix::operator*(const Matrix &rhs) const {
   if (m_cols != rhs.m_rows)
     throw SizeMismatchException{};
-  Matrix res = Matrix(m_rows, rhs.m_cols);
+  Matrix res = Matrix(m_rows, rhs.m_cols, off_diag_default, off_diag_default);
   const size_t common_dimension = m_cols;
-  for (size_t i = 0; i < res.getRows(); i++) {
-    for (size_t j = 0; j < res.getCols(); j++) {
-      double value = 0;
-      for (size_t s = 0; s < common_dimension; s++) {
-        value += (*this)[i][s] * rhs[s][j];
+  const size_t block = tuning::blockSizes().multiply;
+  const auto &row_kernels = kernels::active();
+  for (size_t ii = 0; ii < res.m_rows; ii += block) {
+    const size_t i_end = std::min(res.m_rows, ii + block);
+    for (size_t ss = 0; ss < common_dimension; ss += block) {
+      const size_t s_end = std::min(common_dimension, ss + block);
+      for (size_t jj = 0; jj < res.m_cols; jj += block) {
+        const size_t width = std::min(res.m_cols, jj + block) - jj;
+        for (size_t i = ii; i < i_end; i++) {
+          double *res_i = res.m_data[i].data() + jj;
+          const double *lhs_i = m_data[i].data();
+          for (size_t s = ss; s < s_end; s++) {
+            row_kernels.axpy(width, lhs_i[s], rhs.m_data[s].data() + jj, res_i);
+          }
+        }
       }
-      res[i][j] = value;
     }
   }
   return res;
 }
 Matrix Matrix::operator*(const double &number) const {
   Matrix res = *this;
-  res.transform([number](Matrix &lhs, size_t row, size_t col) {
-    lhs[row][col] *= number;
-  });
+  res *= number;
   return res;
 }
 
@@ -320,6 +452,20 @@ size_t Matrix::getCols() const {
   return m_cols;
 }
 
+void Matrix::setCopyOnWrite(bool enabled) {
+  m_copy_on_write = enabled;
+  if (!enabled)
+    detach();
+}
+
+bool Matrix::copyOnWrite() const {
+  return m_copy_on_write;
+}
+
+bool Matrix::isShared() const {
+  return m_refs && *m_refs > 1;
+}
+
 double Matrix::trace() const {
   if (m_rows != m_cols)
     throw SizeMismatchException{};
@@ -330,11 +476,21 @@ double Matrix::trace() const {
   return sum;
 }
 
+// Copy by square tiles, so both source rows and destination rows
+// of a tile stay in cache
 Matrix Matrix::transposed() const {
   Matrix res(m_cols, m_rows);
-  for (size_t row = 0; row < m_rows; row++) {
-    for (size_t col = 0; col < m_cols; col++) {
-      res[col][row] = (*this)[row][col];
+  const size_t block = tuning::blockSizes().transpose;
+  for (size_t rr = 0; rr < m_rows; rr += block) {
+    const size_t r_end = std::min(m_rows, rr + block);
+    for (size_t cc = 0; cc < m_cols; cc += block) {
+      const size_t c_end = std::min(m_cols, cc + block);
+      for (size_t row = rr; row < r_end; row++) {
+        const double *src = m_data[row].data();
+        for (size_t col = cc; col < c_end; col++) {
+          res.m_data[col].data()[row] = src[col];
+        }
+      }
     }
   }
   return res;
@@ -344,50 +500,142 @@ void Matrix::transpose() {
   *this = transposed();
 }
 
-Matrix Matrix::upperTriangularForm() const {
-  constexpr double min_on_diagonal = 1.e-12;
-  constexpr double min_for_division = 1.e-64;
-  Matrix matrix_a = (*this);
+bool Matrix::factorizeLU(size_t block, bool &odd_permutation,
+                         std::vector<size_t> *permutation) {
+  const size_t dim = m_rows;
+  const auto &row_kernels = kernels::active();
+  odd_permutation = false;
+  detach();
+  if (permutation) {
+    permutation->resize(dim);
+    std::iota(permutation->begin(), permutation->end(), 0);
+  }
 
-  if (matrix_a.m_rows <= 1)
-    return matrix_a;
+  for (size_t k0 = 0; k0 < dim; k0 += block) {
+    const size_t k_end = std::min(dim, k0 + block);
 
-  // direct sweep
-  const size_t dim = matrix_a.getRows();
-  for (size_t k = 0; k < dim - 1; k++) {
+    // factorize panel of columns [k0, k_end) over rows [k0, dim)
+    for (size_t k = k0; k < k_end; k++) {
+      size_t pivot_row = k;
+      for (size_t i = k + 1; i < dim; i++) {
+        if (fabs(m_data[i].data()[k]) > fabs(m_data[pivot_row].data()[k]))
+          pivot_row = i;
+      }
+      if (m_data[pivot_row].data()[k] == 0.)
+        return false;
+      if (pivot_row != k) {
+        m_data[k].swap(m_data[pivot_row]);
+        odd_permutation = !odd_permutation;
+        if (permutation)
+          std::swap((*permutation)[k], (*permutation)[pivot_row]);
+      }
 
-    double pivot = matrix_a[k][k];
-    // zero column case
-    if (fabs (pivot) < min_on_diagonal) {
-      continue;
+      const double *row_k = m_data[k].data();
+      for (size_t i = k + 1; i < dim; i++) {
+        double *row_i = m_data[i].data();
+        const double l = row_i[k] / row_k[k];
+        row_i[k] = l;
+        row_kernels.axpy(k_end - k - 1, -l, row_k + k + 1, row_i + k + 1);
+      }
+    }
+    if (k_end == dim)
+      break;
+
+    // U12 = L11^{-1} * A12
+    const size_t width = dim - k_end;
+    for (size_t k = k0; k < k_end; k++) {
+      const double *row_k = m_data[k].data();
+      for (size_t i = k + 1; i < k_end; i++) {
+        double *row_i = m_data[i].data();
+        row_kernels.axpy(width, -row_i[k], row_k + k_end, row_i + k_end);
+      }
     }
 
-    // subtract k-th row from lower rows
-    // a_{ij} = a_{ij} - a_{ik} * a_{kj} / a_{kk}
-    auto rv_k = matrix_a[k];
-    for (size_t i = k + 1; i < dim; i++) {
-      auto rv_i = matrix_a[i];
-      double t = rv_i[k];
-      rv_i[k] = 0.;
-      for (size_t j = k + 1; j < dim; j++) {
-        if (fabs(rv_k[j]) > min_for_division)
-          rv_i[j] -= t * rv_k[j] / pivot;
+    // A22 -= L21 * U12
+    for (size_t i = k_end; i < dim; i++) {
+      double *row_i = m_data[i].data();
+      for (size_t k = k0; k < k_end; k++) {
+        row_kernels.axpy(width, -row_i[k], m_data[k].data() + k_end, row_i + k_end);
       }
     }
   }
-  return matrix_a;
+  return true;
 }
 
 double Matrix::det() const {
   if (m_rows != m_cols)
     throw SizeMismatchException{};
-  Matrix mat = upperTriangularForm();
-  double det = 1;
+  Matrix lu = *this;
+  bool odd_permutation = false;
+  if (!lu.factorizeLU(tuning::blockSizes().lu, odd_permutation))
+    return 0.;
+  double det = odd_permutation ? -1. : 1.;
   for (size_t row = 0; row < m_rows; row++)
-    det *= mat[row][row];
+    det *= lu.m_data[row].data()[row];
   return det;
 }
 
+double Matrix::inverse(Matrix &destination, double *determinant) const {
+  if (m_rows != m_cols)
+    throw SizeMismatchException{};
+  const size_t dim = m_rows;
+  // taken before @destination is written, it may be *this
+  const double norm = oneNorm(*this);
+
+  Matrix lu = *this;
+  bool odd_permutation = false;
+  std::vector<size_t> permutation;
+  if (!lu.factorizeLU(tuning::blockSizes().lu, odd_permutation, &permutation))
+    throw SingularMatrixException{};
+  if (determinant) {
+    *determinant = odd_permutation ? -1. : 1.;
+    for (size_t row = 0; row < dim; row++)
+      *determinant *= lu.m_data[row].data()[row];
+  }
+
+  if (destination.m_rows != dim || destination.m_cols != dim)
+    destination = Matrix(dim, dim, 0., 0.);
+  destination.detach();
+
+  // L * U * X = P, rows of X start as rows of P
+  std::vector<const double *> lu_rows(dim);
+  std::vector<double *> x_rows(dim);
+  for (size_t row = 0; row < dim; row++) {
+    lu_rows[row] = lu.m_data[row].data();
+    x_rows[row] = destination.m_data[row].data();
+    std::fill(x_rows[row], x_rows[row] + dim, 0.);
+    x_rows[row][permutation[row]] = 1.;
+  }
+
+  // column blocks are independent, threads take them one by one
+  const size_t block = std::max<size_t>(8, tuning::blockSizes().multiply);
+  const size_t block_count = (dim + block - 1) / block;
+  std::atomic<size_t> next_block{0};
+  auto worker = [&] {
+    for (size_t b = next_block++; b < block_count; b = next_block++) {
+      const size_t begin = b * block;
+      substitute(lu_rows, x_rows, begin, std::min(dim, begin + block));
+    }
+  };
+  size_t thread_count = dim < min_parallel_dim ? 1 : std::thread::hardware_concurrency();
+  thread_count = std::max<size_t>(1, std::min(thread_count, block_count));
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < thread_count; t++)
+    threads.emplace_back(worker);
+  worker();
+  for (auto &thread : threads)
+    thread.join();
+
+  // |A| * |A^{-1}| >= 1, rounding may push the product just below
+  return std::min(1., 1. / (norm * oneNorm(destination)));
+}
+
+Matrix Matrix::inverted() const {
+  Matrix res(m_rows, m_cols, 0., 0.);
+  inverse(res);
+  return res;
+}
+
 Matrix task::operator*(const double &a, const Matrix &b) {
   return b * a;
 }
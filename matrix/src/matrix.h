@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <vector>
 #include <iostream>
 
@@ -10,6 +11,7 @@ static constexpr double EPS = 1e-6;
 
 class OutOfBoundsException : public std::exception {};
 class SizeMismatchException : public std::exception {};
+class SingularMatrixException : public std::exception {};
 
 // Row declaration
 class Row {
@@ -27,9 +29,16 @@ public:
   Row &operator=(const Row &rhs);
   ~Row();
 
+  void swap(Row &rhs) noexcept;
+
   // getters
   double &operator[](size_t col);
   const double &operator[](size_t col) const;
+
+  // Raw contiguous storage, used by row kernels
+  double *data();
+  const double *data() const;
+  size_t size() const;
 };
 
 class RowView {
@@ -38,15 +47,37 @@ public:
   explicit RowView(Row &row);
   double &operator[](size_t col);
   const double &operator[](size_t col) const;
+
+  // Raw contiguous storage of the row
+  double *data();
+  const double *data() const;
+};
+
+// Read-only row of a const matrix. It has no write access at all, so rows
+// shared in copy-on-write mode cannot be changed bypassing detach()
+class ConstRowView {
+  const Row *m_row = nullptr;
+public:
+  explicit ConstRowView(const Row &row);
+  const double &operator[](size_t col) const;
+
+  // Raw contiguous storage of the row
+  const double *data() const;
 };
 
-// Matrix declaration
+// Matrix declaration.
+// Copies are deep unless the source is in copy-on-write mode, see
+// setCopyOnWrite()
 class Matrix {
 private:
   // Matrix == array of rows
   size_t m_rows = 0;
   size_t m_cols = 0;
   Row *m_data = nullptr;
+  // Number of matrices sharing m_data, allocated together with it
+  std::atomic<size_t> *m_refs = nullptr;
+  // Copies of this matrix share m_data
+  bool m_copy_on_write = false;
 
   // Defaults
   static constexpr size_t default_size = 1;
@@ -57,21 +88,22 @@ private:
   // Init with ones on the main diagonal, zeros otherwise
   void initialize(double diag_value, double off_diag_value);
 
-  // Free all data
+  // Allocate @m_rows unshared rows of @m_cols
+  void allocate();
+
+  // Release this matrix share of the data, free it if it was the last one
   void clear();
 
-  // Get upper triangular form of original matrix by gauss elimination
-  Matrix upperTriangularForm() const;
+  // Make own copy of shared data before modification
+  void detach();
 
-  // Update matrix by Func(Matrix&, size_t, size_t)
-  template<typename Func>
-  void transform(Func f) {
-    for (size_t row = 0; row < m_rows; row++) {
-      for (size_t col = 0; col < m_cols; col++) {
-        f(*this, row, col);
-      }
-    }
-  }
+  // In-place LU factorization with partial pivoting, L (unit diagonal) and U
+  // are packed into the matrix, rows are physically swapped.
+  // Right-looking, panels of @block columns, trailing matrix is updated by
+  // row kernels. Returns false if a zero pivot is met (matrix is singular).
+  // If @permutation is given, it receives the original index of every row
+  bool factorizeLU(size_t block, bool &odd_permutation,
+                   std::vector<size_t> *permutation = nullptr);
 
 public:
     // constructors
@@ -90,7 +122,7 @@ public:
   void resize(size_t new_rows, size_t new_cols);
 
   RowView operator[](size_t row);
-  const RowView operator[](size_t row) const;
+  ConstRowView operator[](size_t row) const;
 
   Matrix &operator+=(const Matrix &rhs);
   Matrix &operator-=(const Matrix &rhs);
@@ -110,9 +142,32 @@ public:
   double trace() const;
   double det() const;
 
+  // Writes A^{-1} into @destination, its storage is reused when it already
+  // has the right shape. LU with partial pivoting, then substitution over
+  // column blocks of the result spread across threads. Returns reciprocal
+  // condition number 1 / (|A|_1 * |A^{-1}|_1), values near machine epsilon
+  // mean the inverse is unreliable. Stores det(A) into @determinant if given.
+  // Throws SizeMismatchException if A is not square and
+  // SingularMatrixException on a zero pivot
+  double inverse(Matrix &destination, double *determinant = nullptr) const;
+  Matrix inverted() const;
+
   size_t getRows() const;
   size_t getCols() const;
 
+  // Copy-on-write mode, off by default. Copies made from a matrix in this
+  // mode share its rows until one of them is first modified through
+  // non-const get, set, operator[] or an in-place operation, then that one
+  // deep-copies the buffer. Copies inherit the mode, assignment keeps the
+  // mode of the target. RowView obtained before copying keeps pointing into
+  // the shared buffer, so in this mode take views after copies are made.
+  // Turning the mode off gives the matrix its own rows
+  void setCopyOnWrite(bool enabled);
+  bool copyOnWrite() const;
+
+  // True if the data is shared with other copies
+  bool isShared() const;
+
   std::vector<double> getRow(size_t row) const;
   std::vector<double> getColumn(size_t column) const;
 
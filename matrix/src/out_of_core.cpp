@@ -0,0 +1,170 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <future>
+#include <utility>
+
+#include "out_of_core.h"
+
+using namespace task;
+
+/////////////////////////// Matrix file implementation
+
+MatrixFile::MatrixFile(std::string path, size_t rows, size_t cols)
+  : m_path(std::move(path))
+  , m_rows(rows)
+  , m_cols(cols)
+{
+}
+
+MatrixFile::MatrixFile(const std::string &path)
+  : m_path(path)
+{
+  std::ifstream input(m_path, std::ios::binary);
+  uint64_t header[2];
+  if (!input.read(reinterpret_cast<char *>(header), header_size))
+    throw FileAccessException{};
+  m_rows = header[0];
+  m_cols = header[1];
+}
+
+MatrixFile MatrixFile::create(const std::string &path, size_t rows, size_t cols) {
+  std::ofstream output(path, std::ios::binary | std::ios::trunc);
+  const uint64_t header[2] = {rows, cols};
+  output.write(reinterpret_cast<const char *>(header), header_size);
+  // extend file to full size without writing every zero
+  if (rows > 0 && cols > 0) {
+    output.seekp(header_size + rows * cols * sizeof(double) - 1);
+    output.put('\0');
+  }
+  if (!output)
+    throw FileAccessException{};
+  return MatrixFile(path, rows, cols);
+}
+
+MatrixFile MatrixFile::save(const std::string &path, const Matrix &matrix) {
+  MatrixFile file = create(path, matrix.getRows(), matrix.getCols());
+  file.writeTile(0, 0, matrix);
+  return file;
+}
+
+size_t MatrixFile::offset(size_t row, size_t col) const {
+  return header_size + (row * m_cols + col) * sizeof(double);
+}
+
+Matrix MatrixFile::load() const {
+  return readTile(0, 0, m_rows, m_cols);
+}
+
+Matrix MatrixFile::readTile(size_t row, size_t col, size_t rows, size_t cols) const {
+  if (row > m_rows || col > m_cols)
+    throw OutOfBoundsException{};
+  rows = std::min(rows, m_rows - row);
+  cols = std::min(cols, m_cols - col);
+  Matrix tile(rows, cols, 0., 0.);
+  if (cols == 0)
+    return tile;
+
+  std::ifstream input(m_path, std::ios::binary);
+  for (size_t r = 0; r < rows; r++) {
+    input.seekg(offset(row + r, col));
+    input.read(reinterpret_cast<char *>(tile[r].data()), cols * sizeof(double));
+  }
+  if (!input)
+    throw FileAccessException{};
+  return tile;
+}
+
+void MatrixFile::writeTile(size_t row, size_t col, const Matrix &tile) const {
+  if (row + tile.getRows() > m_rows || col + tile.getCols() > m_cols)
+    throw OutOfBoundsException{};
+  const size_t cols = tile.getCols();
+  if (cols == 0)
+    return;
+
+  std::fstream output(m_path, std::ios::binary | std::ios::in | std::ios::out);
+  for (size_t r = 0; r < tile.getRows(); r++) {
+    output.seekp(offset(row + r, col));
+    output.write(reinterpret_cast<const char *>(tile[r].data()), cols * sizeof(double));
+  }
+  if (!output)
+    throw FileAccessException{};
+}
+
+const std::string &MatrixFile::getPath() const {
+  return m_path;
+}
+
+size_t MatrixFile::getRows() const {
+  return m_rows;
+}
+
+size_t MatrixFile::getCols() const {
+  return m_cols;
+}
+
+/////////////////////////// Out-of-core multiplication
+
+OutOfCoreStats task::multiplyOutOfCore(const MatrixFile &a, const MatrixFile &b,
+                                       const MatrixFile &c, size_t memory_budget) {
+  if (a.getCols() != b.getRows() || c.getRows() != a.getRows() ||
+      c.getCols() != b.getCols())
+    throw SizeMismatchException{};
+
+  // A and B tiles, prefetched A and B tiles, accumulator, product, written tile
+  constexpr size_t resident_tiles = 7;
+  OutOfCoreStats stats;
+  stats.tile_size = std::max<size_t>(
+      1, static_cast<size_t>(std::sqrt(memory_budget / (resident_tiles * sizeof(double)))));
+  const size_t tile = stats.tile_size;
+
+  auto blocks = [tile](size_t size) { return (size + tile - 1) / tile; };
+  const size_t row_blocks = blocks(a.getRows());
+  const size_t col_blocks = blocks(b.getCols());
+  const size_t inner_blocks = blocks(a.getCols());
+  const size_t total_steps = row_blocks * col_blocks * inner_blocks;
+
+  // step enumerates (row block, col block, inner block) in loop order
+  using TilePair = std::pair<Matrix, Matrix>;
+  auto prefetch = [&a, &b, tile, col_blocks, inner_blocks](size_t step) {
+    const size_t ib = step / (col_blocks * inner_blocks);
+    const size_t jb = step / inner_blocks % col_blocks;
+    const size_t kb = step % inner_blocks;
+    return std::async(std::launch::async, [&a, &b, tile, ib, jb, kb] {
+      return TilePair(a.readTile(ib * tile, kb * tile, tile, tile),
+                      b.readTile(kb * tile, jb * tile, tile, tile));
+    });
+  };
+
+  std::future<TilePair> next;
+  std::future<void> pending_write;
+  size_t step = 0;
+  if (total_steps > 0)
+    next = prefetch(step);
+
+  for (size_t ib = 0; ib < row_blocks; ib++) {
+    for (size_t jb = 0; jb < col_blocks; jb++) {
+      const size_t rows = std::min(tile, a.getRows() - ib * tile);
+      const size_t cols = std::min(tile, b.getCols() - jb * tile);
+      Matrix acc(rows, cols, 0., 0.);
+      for (size_t kb = 0; kb < inner_blocks; kb++) {
+        TilePair tiles = next.get();
+        if (++step < total_steps)
+          next = prefetch(step);
+        acc += tiles.first * tiles.second;
+        stats.tiles_read += 2;
+      }
+
+      if (pending_write.valid())
+        pending_write.get();
+      pending_write = std::async(std::launch::async,
+                                 [&c, tile, ib, jb, acc = std::move(acc)] {
+                                   c.writeTile(ib * tile, jb * tile, acc);
+                                 });
+      stats.tiles_written++;
+    }
+  }
+  if (pending_write.valid())
+    pending_write.get();
+  return stats;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "matrix.h"
+
+
+namespace task {
+
+class FileAccessException : public std::exception {};
+
+// Matrix stored in a binary file: rows and cols as uint64_t,
+// then rows * cols doubles row by row. Only the requested tiles are
+// ever loaded into memory
+class MatrixFile {
+private:
+  std::string m_path;
+  size_t m_rows = 0;
+  size_t m_cols = 0;
+
+  static constexpr size_t header_size = 2 * sizeof(uint64_t);
+
+private:
+  MatrixFile(std::string path, size_t rows, size_t cols);
+
+  size_t offset(size_t row, size_t col) const;
+
+public:
+  // Opens existing file, throws FileAccessException on failure
+  explicit MatrixFile(const std::string &path);
+
+  // Creates (or truncates) a file holding a zero rows x cols matrix
+  static MatrixFile create(const std::string &path, size_t rows, size_t cols);
+  // Writes @matrix to a new file
+  static MatrixFile save(const std::string &path, const Matrix &matrix);
+
+  // Loads the whole matrix
+  Matrix load() const;
+
+  // Tile with top left corner (@row, @col), clipped by matrix bounds
+  Matrix readTile(size_t row, size_t col, size_t rows, size_t cols) const;
+  // Stores @tile with top left corner at (@row, @col)
+  void writeTile(size_t row, size_t col, const Matrix &tile) const;
+
+  const std::string &getPath() const;
+  size_t getRows() const;
+  size_t getCols() const;
+};
+
+struct OutOfCoreStats {
+  size_t tile_size = 0;
+  size_t tiles_read = 0;
+  size_t tiles_written = 0;
+};
+
+// C = A * B for file-backed matrices, @c must already have matching size.
+// Works on square tiles sized so that all resident tiles (current and
+// prefetched tiles of A and B, accumulator, product and a tile being written)
+// fit into @memory_budget bytes. Reading the next pair of tiles and writing
+// finished C tiles run in background while the current pair is multiplied
+OutOfCoreStats multiplyOutOfCore(const MatrixFile &a, const MatrixFile &b,
+                                 const MatrixFile &c, size_t memory_budget);
+
+}  // namespace task
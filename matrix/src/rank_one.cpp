@@ -0,0 +1,103 @@
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "kernels.h"
+#include "rank_one.h"
+
+using namespace task;
+
+namespace {
+
+// Inputs with reciprocal condition number below this are treated as singular
+constexpr double min_rcond = std::numeric_limits<double>::epsilon();
+
+}  // namespace
+
+RankOneUpdater::RankOneUpdater(const Matrix &matrix, size_t refactor_period)
+  : m_matrix(matrix)
+  , m_inverse(matrix.getRows(), matrix.getCols())
+  , m_refactor_period(refactor_period > 0 ? refactor_period : matrix.getRows())
+{
+  if (m_matrix.getRows() != m_matrix.getCols())
+    throw SizeMismatchException{};
+  refactorize(m_matrix);
+}
+
+void RankOneUpdater::refactorize(Matrix matrix) {
+  Matrix inverse(matrix.getRows(), matrix.getCols(), 0., 0.);
+  double det = 0;
+  if (matrix.inverse(inverse, &det) < min_rcond)
+    throw SingularMatrixException{};
+  m_matrix = std::move(matrix);
+  m_inverse = std::move(inverse);
+  m_det = det;
+  m_updates = 0;
+}
+
+void RankOneUpdater::update(const std::vector<double> &u,
+                            const std::vector<double> &v) {
+  const size_t dim = m_matrix.getRows();
+  if (u.size() != dim || v.size() != dim)
+    throw SizeMismatchException{};
+  const auto &row_kernels = kernels::active();
+
+  // w = A^{-1} u, z^T = v^T A^{-1}
+  std::vector<double> w(dim, 0.), z(dim, 0.);
+  for (size_t i = 0; i < dim; i++) {
+    const double *inv_i = m_inverse[i].data();
+    double value = 0;
+    for (size_t j = 0; j < dim; j++) {
+      value += inv_i[j] * u[j];
+    }
+    w[i] = value;
+    row_kernels.axpy(dim, v[i], inv_i, z.data());
+  }
+
+  double denominator = 1.;
+  for (size_t i = 0; i < dim; i++) {
+    denominator += v[i] * w[i];
+  }
+  if (fabs(denominator) < min_denominator)
+    throw SingularMatrixException{};
+
+  if (m_updates + 1 >= m_refactor_period) {
+    Matrix updated = m_matrix;
+    for (size_t i = 0; i < dim; i++) {
+      row_kernels.axpy(dim, u[i], v.data(), updated[i].data());
+    }
+    refactorize(std::move(updated));
+    return;
+  }
+
+  for (size_t i = 0; i < dim; i++) {
+    row_kernels.axpy(dim, u[i], v.data(), m_matrix[i].data());
+    row_kernels.axpy(dim, -w[i] / denominator, z.data(), m_inverse[i].data());
+  }
+  m_det *= denominator;
+  m_updates++;
+}
+
+void RankOneUpdater::refresh() {
+  refactorize(m_matrix);
+}
+
+const Matrix &RankOneUpdater::getMatrix() const {
+  return m_matrix;
+}
+
+const Matrix &RankOneUpdater::getInverse() const {
+  return m_inverse;
+}
+
+double RankOneUpdater::det() const {
+  return m_det;
+}
+
+size_t RankOneUpdater::getRefactorPeriod() const {
+  return m_refactor_period;
+}
+
+size_t RankOneUpdater::getUpdatesSinceRefactorization() const {
+  return m_updates;
+}
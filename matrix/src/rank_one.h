@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+
+#include "matrix.h"
+
+
+namespace task {
+
+// Keeps A, A^{-1} and det(A) in sync under rank-1 updates A += u * v^T.
+// Each update costs O(n^2):
+//   det(A + u v^T) = det(A) * (1 + v^T A^{-1} u)          (determinant lemma)
+//   (A + u v^T)^{-1} = A^{-1} - A^{-1} u v^T A^{-1} / (1 + v^T A^{-1} u)
+//                                                          (Sherman-Morrison)
+// Rounding errors accumulate, so A^{-1} and det(A) are recomputed from A
+// from scratch every @refactor_period updates
+class RankOneUpdater {
+private:
+  Matrix m_matrix;
+  Matrix m_inverse;
+  double m_det = 1;
+  size_t m_refactor_period = 0;
+  size_t m_updates = 0;
+
+  // Denominators below this mean the updated matrix is singular
+  static constexpr double min_denominator = 1.e-12;
+
+private:
+  // Replace A by @matrix and recompute inverse and determinant, O(n^3),
+  // state is kept untouched if @matrix is singular
+  void refactorize(Matrix matrix);
+
+public:
+  // @refactor_period == 0 means refactorization every n updates,
+  // which keeps amortized cost of update O(n^2)
+  explicit RankOneUpdater(const Matrix &matrix, size_t refactor_period = 0);
+
+  // A += u * v^T, throws SizeMismatchException for wrong sizes and
+  // SingularMatrixException (leaving state untouched) if A becomes singular
+  void update(const std::vector<double> &u, const std::vector<double> &v);
+
+  // Recompute inverse and determinant now
+  void refresh();
+
+  const Matrix &getMatrix() const;
+  const Matrix &getInverse() const;
+  double det() const;
+
+  size_t getRefactorPeriod() const;
+  size_t getUpdatesSinceRefactorization() const;
+};
+
+}  // namespace task
@@ -0,0 +1,770 @@
+#include <algorithm>
+#include <cmath>
+
+#include "structured_matrix.h"
+
+using namespace task;
+
+namespace {
+
+// Pivots up to this fraction of the largest entry are treated as zeros by
+// solvers, so the threshold does not depend on matrix scale
+constexpr double min_relative_pivot = 1.e-12;
+
+// Allocates @size doubles filled with zeros, nullptr for empty storage
+double *allocate(size_t size) {
+  return size > 0 ? new double[size]() : nullptr;
+}
+
+double maxAbs(const double *data, size_t size) {
+  double res = 0;
+  for (size_t k = 0; k < size; k++)
+    res = std::max(res, fabs(data[k]));
+  return res;
+}
+
+double *duplicate(const double *src, size_t size) {
+  double *dst = allocate(size);
+  if (size > 0) {
+    std::copy(src, src + size, dst);
+  }
+  return dst;
+}
+
+}  // namespace
+
+/////////////////////////// Triangular matrix implementation
+
+TriangularMatrix::TriangularMatrix(size_t dim, Triangle triangle,
+                                   double diag_value)
+  : m_dim(dim)
+  , m_triangle(triangle)
+  , m_data(allocate(m_dim * (m_dim + 1) / 2))
+{
+  for (size_t i = 0; i < m_dim; i++) {
+    m_data[index(i, i)] = diag_value;
+  }
+}
+
+TriangularMatrix::TriangularMatrix(const Matrix &dense, Triangle triangle)
+  : m_dim(dense.getRows())
+  , m_triangle(triangle)
+  , m_data(nullptr)
+{
+  if (dense.getRows() != dense.getCols())
+    throw SizeMismatchException{};
+  m_data = allocate(m_dim * (m_dim + 1) / 2);
+  for (size_t row = 0; row < m_dim; row++) {
+    for (size_t col = 0; col < m_dim; col++) {
+      if (inTriangle(row, col))
+        m_data[index(row, col)] = dense[row][col];
+    }
+  }
+}
+
+TriangularMatrix::TriangularMatrix(const TriangularMatrix &rhs)
+  : m_dim(rhs.m_dim)
+  , m_triangle(rhs.m_triangle)
+  , m_data(duplicate(rhs.m_data, m_dim * (m_dim + 1) / 2))
+{
+}
+
+TriangularMatrix::TriangularMatrix(TriangularMatrix &&rhs) noexcept
+  : m_dim(rhs.m_dim)
+  , m_triangle(rhs.m_triangle)
+  , m_data(rhs.m_data)
+{
+  rhs.m_dim = 0;
+  rhs.m_data = nullptr;
+}
+
+TriangularMatrix &TriangularMatrix::operator=(const TriangularMatrix &rhs) {
+  if (this != &rhs) {
+    clear();
+    m_dim = rhs.m_dim;
+    m_triangle = rhs.m_triangle;
+    m_data = duplicate(rhs.m_data, m_dim * (m_dim + 1) / 2);
+  }
+  return *this;
+}
+
+TriangularMatrix &TriangularMatrix::operator=(TriangularMatrix &&rhs) noexcept {
+  if (this != &rhs) {
+    clear();
+    std::swap(m_dim, rhs.m_dim);
+    std::swap(m_triangle, rhs.m_triangle);
+    std::swap(m_data, rhs.m_data);
+  }
+  return *this;
+}
+
+TriangularMatrix::~TriangularMatrix() {
+  clear();
+}
+
+void TriangularMatrix::clear() {
+  delete[] m_data;
+  m_data = nullptr;
+  m_dim = 0;
+}
+
+// Upper: row r keeps columns [r, n), Lower: row r keeps columns [0, r]
+size_t TriangularMatrix::index(size_t row, size_t col) const {
+  if (m_triangle == Triangle::Upper)
+    return row * m_dim - row * (row - 1) / 2 + (col - row);
+  return row * (row + 1) / 2 + col;
+}
+
+bool TriangularMatrix::inTriangle(size_t row, size_t col) const {
+  return m_triangle == Triangle::Upper ? col >= row : col <= row;
+}
+
+double TriangularMatrix::get(size_t row, size_t col) const {
+  if (row >= m_dim || col >= m_dim)
+    throw OutOfBoundsException{};
+  return inTriangle(row, col) ? m_data[index(row, col)] : 0.;
+}
+
+void TriangularMatrix::set(size_t row, size_t col, double value) {
+  if (row >= m_dim || col >= m_dim || !inTriangle(row, col))
+    throw OutOfBoundsException{};
+  m_data[index(row, col)] = value;
+}
+
+size_t TriangularMatrix::getDim() const {
+  return m_dim;
+}
+
+Triangle TriangularMatrix::getTriangle() const {
+  return m_triangle;
+}
+
+Matrix TriangularMatrix::operator*(const Matrix &rhs) const {
+  if (m_dim != rhs.getRows())
+    throw SizeMismatchException{};
+  const size_t cols = rhs.getCols();
+  Matrix res(m_dim, cols, 0., 0.);
+  for (size_t i = 0; i < m_dim; i++) {
+    const size_t first = m_triangle == Triangle::Upper ? i : 0;
+    const size_t last = m_triangle == Triangle::Upper ? m_dim : i + 1;
+    auto res_i = res[i];
+    for (size_t s = first; s < last; s++) {
+      const double a = m_data[index(i, s)];
+      const auto rhs_s = rhs[s];
+      for (size_t j = 0; j < cols; j++) {
+        res_i[j] += a * rhs_s[j];
+      }
+    }
+  }
+  return res;
+}
+
+std::vector<double> TriangularMatrix::operator*(const std::vector<double> &x) const {
+  if (m_dim != x.size())
+    throw SizeMismatchException{};
+  std::vector<double> res(m_dim, 0.);
+  for (size_t i = 0; i < m_dim; i++) {
+    const size_t first = m_triangle == Triangle::Upper ? i : 0;
+    const size_t last = m_triangle == Triangle::Upper ? m_dim : i + 1;
+    for (size_t s = first; s < last; s++) {
+      res[i] += m_data[index(i, s)] * x[s];
+    }
+  }
+  return res;
+}
+
+std::vector<double> TriangularMatrix::solve(const std::vector<double> &b) const {
+  if (m_dim != b.size())
+    throw SizeMismatchException{};
+  std::vector<double> x = b;
+  const double tolerance = min_relative_pivot * maxAbs(m_data, m_dim * (m_dim + 1) / 2);
+  if (m_triangle == Triangle::Lower) {
+    // forward substitution
+    for (size_t i = 0; i < m_dim; i++) {
+      const double pivot = m_data[index(i, i)];
+      if (!(fabs(pivot) > tolerance))
+        throw SingularMatrixException{};
+      for (size_t s = 0; s < i; s++) {
+        x[i] -= m_data[index(i, s)] * x[s];
+      }
+      x[i] /= pivot;
+    }
+  } else {
+    // backward substitution
+    for (size_t i = m_dim; i-- > 0;) {
+      const double pivot = m_data[index(i, i)];
+      if (!(fabs(pivot) > tolerance))
+        throw SingularMatrixException{};
+      for (size_t s = i + 1; s < m_dim; s++) {
+        x[i] -= m_data[index(i, s)] * x[s];
+      }
+      x[i] /= pivot;
+    }
+  }
+  return x;
+}
+
+double TriangularMatrix::det() const {
+  double det = 1;
+  for (size_t i = 0; i < m_dim; i++)
+    det *= m_data[index(i, i)];
+  return det;
+}
+
+Matrix TriangularMatrix::toMatrix() const {
+  Matrix res(m_dim, m_dim, 0., 0.);
+  for (size_t row = 0; row < m_dim; row++) {
+    for (size_t col = 0; col < m_dim; col++) {
+      res[row][col] = get(row, col);
+    }
+  }
+  return res;
+}
+
+/////////////////////////// Symmetric matrix implementation
+
+SymmetricMatrix::SymmetricMatrix(size_t dim, double diag_value,
+                                 double off_diag_value)
+  : m_dim(dim)
+  , m_data(allocate(m_dim * (m_dim + 1) / 2))
+{
+  for (size_t row = 0; row < m_dim; row++) {
+    for (size_t col = 0; col <= row; col++) {
+      m_data[index(row, col)] = (row == col) ? diag_value : off_diag_value;
+    }
+  }
+}
+
+SymmetricMatrix::SymmetricMatrix(const Matrix &dense)
+  : m_dim(dense.getRows())
+  , m_data(nullptr)
+{
+  if (dense.getRows() != dense.getCols())
+    throw SizeMismatchException{};
+  m_data = allocate(m_dim * (m_dim + 1) / 2);
+  for (size_t row = 0; row < m_dim; row++) {
+    for (size_t col = 0; col <= row; col++) {
+      m_data[index(row, col)] = dense[row][col];
+    }
+  }
+}
+
+SymmetricMatrix::SymmetricMatrix(const SymmetricMatrix &rhs)
+  : m_dim(rhs.m_dim)
+  , m_data(duplicate(rhs.m_data, m_dim * (m_dim + 1) / 2))
+{
+}
+
+SymmetricMatrix::SymmetricMatrix(SymmetricMatrix &&rhs) noexcept
+  : m_dim(rhs.m_dim)
+  , m_data(rhs.m_data)
+{
+  rhs.m_dim = 0;
+  rhs.m_data = nullptr;
+}
+
+SymmetricMatrix &SymmetricMatrix::operator=(const SymmetricMatrix &rhs) {
+  if (this != &rhs) {
+    clear();
+    m_dim = rhs.m_dim;
+    m_data = duplicate(rhs.m_data, m_dim * (m_dim + 1) / 2);
+  }
+  return *this;
+}
+
+SymmetricMatrix &SymmetricMatrix::operator=(SymmetricMatrix &&rhs) noexcept {
+  if (this != &rhs) {
+    clear();
+    std::swap(m_dim, rhs.m_dim);
+    std::swap(m_data, rhs.m_data);
+  }
+  return *this;
+}
+
+SymmetricMatrix::~SymmetricMatrix() {
+  clear();
+}
+
+void SymmetricMatrix::clear() {
+  delete[] m_data;
+  m_data = nullptr;
+  m_dim = 0;
+}
+
+// Lower triangle packed by rows, row r keeps columns [0, r]
+size_t SymmetricMatrix::index(size_t row, size_t col) const {
+  if (col > row)
+    std::swap(row, col);
+  return row * (row + 1) / 2 + col;
+}
+
+double SymmetricMatrix::get(size_t row, size_t col) const {
+  if (row >= m_dim || col >= m_dim)
+    throw OutOfBoundsException{};
+  return m_data[index(row, col)];
+}
+
+void SymmetricMatrix::set(size_t row, size_t col, double value) {
+  if (row >= m_dim || col >= m_dim)
+    throw OutOfBoundsException{};
+  m_data[index(row, col)] = value;
+}
+
+size_t SymmetricMatrix::getDim() const {
+  return m_dim;
+}
+
+Matrix SymmetricMatrix::operator*(const Matrix &rhs) const {
+  if (m_dim != rhs.getRows())
+    throw SizeMismatchException{};
+  const size_t cols = rhs.getCols();
+  Matrix res(m_dim, cols, 0., 0.);
+  for (size_t i = 0; i < m_dim; i++) {
+    auto res_i = res[i];
+    for (size_t s = 0; s < m_dim; s++) {
+      const double a = m_data[index(i, s)];
+      const auto rhs_s = rhs[s];
+      for (size_t j = 0; j < cols; j++) {
+        res_i[j] += a * rhs_s[j];
+      }
+    }
+  }
+  return res;
+}
+
+std::vector<double> SymmetricMatrix::operator*(const std::vector<double> &x) const {
+  if (m_dim != x.size())
+    throw SizeMismatchException{};
+  std::vector<double> res(m_dim, 0.);
+  // every stored off-diagonal entry contributes twice
+  for (size_t i = 0; i < m_dim; i++) {
+    const double *row = m_data + i * (i + 1) / 2;
+    for (size_t s = 0; s < i; s++) {
+      res[i] += row[s] * x[s];
+      res[s] += row[s] * x[i];
+    }
+    res[i] += row[i] * x[i];
+  }
+  return res;
+}
+
+// Bunch-Kaufman diagonal pivoting on the packed lower triangle,
+// P * A * P^T = L * D * L^T with unit lower L and D of 1x1 and 2x2 blocks.
+// Column k is eliminated with a 1x1 pivot when its diagonal is large enough
+// relative to the column, otherwise with the largest off-diagonal entry
+// moved next to it as a 2x2 block, element growth stays bounded for
+// indefinite matrices at n^3 / 3 flops and no storage beyond the copy.
+// Row i of @ld keeps L(i, j) for j < i, except (k + 1, k) of a 2x2 block
+// starting at k (marked in @block) which is the off-diagonal entry of D
+bool SymmetricMatrix::factorize(double *ld, size_t *perm, char *block) const {
+  // (1 + sqrt(17)) / 8 minimizes the growth bound
+  static const double alpha = (1. + std::sqrt(17.)) / 8.;
+  const size_t size = m_dim * (m_dim + 1) / 2;
+  std::copy(m_data, m_data + size, ld);
+  const double tolerance = min_relative_pivot * maxAbs(m_data, size);
+  auto at = [ld, this](size_t row, size_t col) -> double & {
+    return ld[index(row, col)];
+  };
+  for (size_t i = 0; i < m_dim; i++) {
+    perm[i] = i;
+    block[i] = 0;
+  }
+
+  for (size_t k = 0; k < m_dim;) {
+    const double diag = fabs(at(k, k));
+    double col_max = 0;
+    size_t max_row = k;
+    for (size_t i = k + 1; i < m_dim; i++) {
+      if (fabs(at(i, k)) > col_max) {
+        col_max = fabs(at(i, k));
+        max_row = i;
+      }
+    }
+    if (!(std::max(diag, col_max) > tolerance))
+      return false;
+
+    size_t step = 1;
+    size_t pivot = k;
+    if (diag < alpha * col_max) {
+      double row_max = 0;
+      for (size_t j = k; j < m_dim; j++) {
+        if (j != max_row)
+          row_max = std::max(row_max, fabs(at(max_row, j)));
+      }
+      if (diag >= alpha * col_max * (col_max / row_max)) {
+        // 1x1 pivot at k is good enough
+      } else if (fabs(at(max_row, max_row)) >= alpha * row_max) {
+        pivot = max_row;
+      } else {
+        pivot = max_row;
+        step = 2;
+      }
+    }
+
+    // symmetric interchange of rows and columns p and q, L columns included
+    const size_t p = k + step - 1;
+    const size_t q = pivot;
+    if (p != q) {
+      for (size_t j = 0; j < p; j++)
+        std::swap(at(p, j), at(q, j));
+      std::swap(at(p, p), at(q, q));
+      for (size_t i = p + 1; i < q; i++)
+        std::swap(at(i, p), at(q, i));
+      for (size_t i = q + 1; i < m_dim; i++)
+        std::swap(at(i, p), at(i, q));
+      std::swap(perm[p], perm[q]);
+    }
+
+    // rows go bottom up, so multipliers of rows above are still unscaled
+    if (step == 1) {
+      const double d = at(k, k);
+      for (size_t i = m_dim; i-- > k + 1;) {
+        const double l = at(i, k) / d;
+        double *row_i = ld + i * (i + 1) / 2;
+        for (size_t j = k + 1; j <= i; j++) {
+          row_i[j] -= l * at(j, k);
+        }
+        row_i[k] = l;
+      }
+    } else {
+      const double a = at(k, k), b = at(k + 1, k), c = at(k + 1, k + 1);
+      const double det = a * c - b * b;
+      for (size_t i = m_dim; i-- > k + 2;) {
+        double *row_i = ld + i * (i + 1) / 2;
+        const double l0 = (c * row_i[k] - b * row_i[k + 1]) / det;
+        const double l1 = (a * row_i[k + 1] - b * row_i[k]) / det;
+        for (size_t j = k + 2; j <= i; j++) {
+          row_i[j] -= l0 * at(j, k) + l1 * at(j, k + 1);
+        }
+        row_i[k] = l0;
+        row_i[k + 1] = l1;
+      }
+      block[k] = 1;
+    }
+    k += step;
+  }
+  return true;
+}
+
+std::vector<double> SymmetricMatrix::solve(const std::vector<double> &b) const {
+  if (m_dim != b.size())
+    throw SizeMismatchException{};
+  std::vector<double> ld(m_dim * (m_dim + 1) / 2);
+  std::vector<size_t> perm(m_dim);
+  std::vector<char> block(m_dim);
+  if (!factorize(ld.data(), perm.data(), block.data()))
+    throw SingularMatrixException{};
+
+  std::vector<double> x(m_dim);
+  for (size_t i = 0; i < m_dim; i++) {
+    x[i] = b[perm[i]];
+  }
+  // L columns of row i end before the D entry of a 2x2 block
+  auto l_cols = [&block](size_t i) { return i > 0 && block[i - 1] ? i - 1 : i; };
+  // L * z = P * b
+  for (size_t i = 0; i < m_dim; i++) {
+    const double *row_i = ld.data() + i * (i + 1) / 2;
+    for (size_t k = 0; k < l_cols(i); k++) {
+      x[i] -= row_i[k] * x[k];
+    }
+  }
+  // D * y = z
+  for (size_t i = 0; i < m_dim; i++) {
+    if (!block[i]) {
+      x[i] /= ld[index(i, i)];
+      continue;
+    }
+    const double a = ld[index(i, i)], b = ld[index(i + 1, i)], c = ld[index(i + 1, i + 1)];
+    const double det = a * c - b * b;
+    const double x0 = x[i], x1 = x[i + 1];
+    x[i] = (c * x0 - b * x1) / det;
+    x[i + 1] = (a * x1 - b * x0) / det;
+    i++;
+  }
+  // L^T * P * x = y
+  for (size_t i = m_dim; i-- > 0;) {
+    const double *row_i = ld.data() + i * (i + 1) / 2;
+    for (size_t k = 0; k < l_cols(i); k++) {
+      x[k] -= row_i[k] * x[i];
+    }
+  }
+  std::vector<double> res(m_dim);
+  for (size_t i = 0; i < m_dim; i++) {
+    res[perm[i]] = x[i];
+  }
+  return res;
+}
+
+// Symmetric interchanges do not change the sign, det(A) = det(D)
+double SymmetricMatrix::det() const {
+  std::vector<double> ld(m_dim * (m_dim + 1) / 2);
+  std::vector<size_t> perm(m_dim);
+  std::vector<char> block(m_dim);
+  if (!factorize(ld.data(), perm.data(), block.data()))
+    return 0.;
+  double det = 1;
+  for (size_t i = 0; i < m_dim; i++) {
+    if (block[i]) {
+      det *= ld[index(i, i)] * ld[index(i + 1, i + 1)] - ld[index(i + 1, i)] * ld[index(i + 1, i)];
+      i++;
+    } else {
+      det *= ld[index(i, i)];
+    }
+  }
+  return det;
+}
+
+Matrix SymmetricMatrix::toMatrix() const {
+  Matrix res(m_dim, m_dim, 0., 0.);
+  for (size_t row = 0; row < m_dim; row++) {
+    for (size_t col = 0; col < m_dim; col++) {
+      res[row][col] = m_data[index(row, col)];
+    }
+  }
+  return res;
+}
+
+/////////////////////////// Band matrix implementation
+
+BandMatrix::BandMatrix(size_t dim, size_t kl, size_t ku, double diag_value)
+  : m_dim(dim)
+  , m_kl(kl)
+  , m_ku(ku)
+  , m_data(allocate(m_dim * width()))
+{
+  for (size_t i = 0; i < m_dim; i++) {
+    m_data[index(i, i)] = diag_value;
+  }
+}
+
+BandMatrix::BandMatrix(const Matrix &dense, size_t kl, size_t ku)
+  : m_dim(dense.getRows())
+  , m_kl(kl)
+  , m_ku(ku)
+  , m_data(nullptr)
+{
+  if (dense.getRows() != dense.getCols())
+    throw SizeMismatchException{};
+  m_data = allocate(m_dim * width());
+  for (size_t row = 0; row < m_dim; row++) {
+    for (size_t col = 0; col < m_dim; col++) {
+      if (inBand(row, col))
+        m_data[index(row, col)] = dense[row][col];
+    }
+  }
+}
+
+BandMatrix::BandMatrix(const BandMatrix &rhs)
+  : m_dim(rhs.m_dim)
+  , m_kl(rhs.m_kl)
+  , m_ku(rhs.m_ku)
+  , m_data(duplicate(rhs.m_data, m_dim * width()))
+{
+}
+
+BandMatrix::BandMatrix(BandMatrix &&rhs) noexcept
+  : m_dim(rhs.m_dim)
+  , m_kl(rhs.m_kl)
+  , m_ku(rhs.m_ku)
+  , m_data(rhs.m_data)
+{
+  rhs.m_dim = 0;
+  rhs.m_data = nullptr;
+}
+
+BandMatrix &BandMatrix::operator=(const BandMatrix &rhs) {
+  if (this != &rhs) {
+    clear();
+    m_dim = rhs.m_dim;
+    m_kl = rhs.m_kl;
+    m_ku = rhs.m_ku;
+    m_data = duplicate(rhs.m_data, m_dim * width());
+  }
+  return *this;
+}
+
+BandMatrix &BandMatrix::operator=(BandMatrix &&rhs) noexcept {
+  if (this != &rhs) {
+    clear();
+    std::swap(m_dim, rhs.m_dim);
+    std::swap(m_kl, rhs.m_kl);
+    std::swap(m_ku, rhs.m_ku);
+    std::swap(m_data, rhs.m_data);
+  }
+  return *this;
+}
+
+BandMatrix::~BandMatrix() {
+  clear();
+}
+
+void BandMatrix::clear() {
+  delete[] m_data;
+  m_data = nullptr;
+  m_dim = 0;
+}
+
+size_t BandMatrix::width() const {
+  return m_kl + m_ku + 1;
+}
+
+size_t BandMatrix::index(size_t row, size_t col) const {
+  return row * width() + (col + m_kl - row);
+}
+
+bool BandMatrix::inBand(size_t row, size_t col) const {
+  return col + m_kl >= row && col <= row + m_ku;
+}
+
+double BandMatrix::get(size_t row, size_t col) const {
+  if (row >= m_dim || col >= m_dim)
+    throw OutOfBoundsException{};
+  return inBand(row, col) ? m_data[index(row, col)] : 0.;
+}
+
+void BandMatrix::set(size_t row, size_t col, double value) {
+  if (row >= m_dim || col >= m_dim || !inBand(row, col))
+    throw OutOfBoundsException{};
+  m_data[index(row, col)] = value;
+}
+
+size_t BandMatrix::getDim() const {
+  return m_dim;
+}
+
+size_t BandMatrix::getLowerBandwidth() const {
+  return m_kl;
+}
+
+size_t BandMatrix::getUpperBandwidth() const {
+  return m_ku;
+}
+
+Matrix BandMatrix::operator*(const Matrix &rhs) const {
+  if (m_dim != rhs.getRows())
+    throw SizeMismatchException{};
+  const size_t cols = rhs.getCols();
+  Matrix res(m_dim, cols, 0., 0.);
+  for (size_t i = 0; i < m_dim; i++) {
+    const size_t first = i > m_kl ? i - m_kl : 0;
+    const size_t last = std::min(m_dim, i + m_ku + 1);
+    auto res_i = res[i];
+    for (size_t s = first; s < last; s++) {
+      const double a = m_data[index(i, s)];
+      const auto rhs_s = rhs[s];
+      for (size_t j = 0; j < cols; j++) {
+        res_i[j] += a * rhs_s[j];
+      }
+    }
+  }
+  return res;
+}
+
+std::vector<double> BandMatrix::operator*(const std::vector<double> &x) const {
+  if (m_dim != x.size())
+    throw SizeMismatchException{};
+  std::vector<double> res(m_dim, 0.);
+  for (size_t i = 0; i < m_dim; i++) {
+    const size_t first = i > m_kl ? i - m_kl : 0;
+    const size_t last = std::min(m_dim, i + m_ku + 1);
+    for (size_t s = first; s < last; s++) {
+      res[i] += m_data[index(i, s)] * x[s];
+    }
+  }
+  return res;
+}
+
+// Row interchanges widen U up to kl + ku superdiagonals,
+// so elimination works on a copy where row i keeps columns [i - kl, i + kl + ku]
+double BandMatrix::eliminate(std::vector<double> *rhs) const {
+  const size_t lu_width = 2 * m_kl + m_ku + 1;
+  const size_t lu_ku = m_kl + m_ku;
+  std::vector<double> lu(m_dim * lu_width, 0.);
+  auto at = [&lu, lu_width, this](size_t row, size_t col) -> double & {
+    return lu[row * lu_width + (col + m_kl - row)];
+  };
+  for (size_t row = 0; row < m_dim; row++) {
+    const size_t first = row > m_kl ? row - m_kl : 0;
+    const size_t last = std::min(m_dim, row + m_ku + 1);
+    for (size_t col = first; col < last; col++) {
+      at(row, col) = m_data[index(row, col)];
+    }
+  }
+
+  const double tolerance = min_relative_pivot * maxAbs(m_data, m_dim * width());
+  double det = 1;
+  for (size_t k = 0; k < m_dim; k++) {
+    const size_t last_row = std::min(m_dim, k + m_kl + 1);
+    const size_t last_col = std::min(m_dim, k + lu_ku + 1);
+
+    // partial pivoting within the band
+    size_t pivot_row = k;
+    for (size_t i = k + 1; i < last_row; i++) {
+      if (fabs(at(i, k)) > fabs(at(pivot_row, k)))
+        pivot_row = i;
+    }
+    const double max_abs = fabs(at(pivot_row, k));
+    if (max_abs == 0. || (rhs && !(max_abs > tolerance))) {
+      if (rhs)
+        throw SingularMatrixException{};
+      return 0.;
+    }
+    if (pivot_row != k) {
+      for (size_t j = k; j < last_col; j++) {
+        std::swap(at(k, j), at(pivot_row, j));
+      }
+      if (rhs)
+        std::swap((*rhs)[k], (*rhs)[pivot_row]);
+      det = -det;
+    }
+
+    const double pivot = at(k, k);
+    det *= pivot;
+    for (size_t i = k + 1; i < last_row; i++) {
+      const double l = at(i, k) / pivot;
+      if (l == 0.)
+        continue;
+      at(i, k) = 0.;
+      for (size_t j = k + 1; j < last_col; j++) {
+        at(i, j) -= l * at(k, j);
+      }
+      if (rhs)
+        (*rhs)[i] -= l * (*rhs)[k];
+    }
+  }
+
+  // back substitution with U
+  if (rhs) {
+    std::vector<double> &x = *rhs;
+    for (size_t i = m_dim; i-- > 0;) {
+      const size_t last_col = std::min(m_dim, i + lu_ku + 1);
+      for (size_t j = i + 1; j < last_col; j++) {
+        x[i] -= at(i, j) * x[j];
+      }
+      x[i] /= at(i, i);
+    }
+  }
+  return det;
+}
+
+std::vector<double> BandMatrix::solve(const std::vector<double> &b) const {
+  if (m_dim != b.size())
+    throw SizeMismatchException{};
+  std::vector<double> x = b;
+  eliminate(&x);
+  return x;
+}
+
+double BandMatrix::det() const {
+  return eliminate(nullptr);
+}
+
+Matrix BandMatrix::toMatrix() const {
+  Matrix res(m_dim, m_dim, 0., 0.);
+  for (size_t row = 0; row < m_dim; row++) {
+    for (size_t col = 0; col < m_dim; col++) {
+      res[row][col] = get(row, col);
+    }
+  }
+  return res;
+}
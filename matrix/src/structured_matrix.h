@@ -0,0 +1,175 @@
+#pragma once
+
+#include <vector>
+
+#include "matrix.h"
+
+
+namespace task {
+
+// Which half of a triangular matrix holds the data
+enum class Triangle { Upper, Lower };
+
+// Triangular matrix declaration,
+// only n * (n + 1) / 2 entries of the stored triangle are kept (packed by rows)
+class TriangularMatrix {
+private:
+  size_t m_dim = 0;
+  Triangle m_triangle = Triangle::Upper;
+  double *m_data = nullptr;
+
+  // Defaults
+  static constexpr size_t default_size = 1;
+  static constexpr double diag_default = 1;
+
+private:
+  // Free all data
+  void clear();
+
+  // Position of (row, col) in packed storage, (row, col) must be in triangle
+  size_t index(size_t row, size_t col) const;
+  bool inTriangle(size_t row, size_t col) const;
+
+public:
+  // constructors
+  explicit TriangularMatrix(size_t dim = default_size,
+                            Triangle triangle = Triangle::Upper,
+                            double diag_value = diag_default);
+  // Takes the given triangle of a square dense matrix
+  TriangularMatrix(const Matrix &dense, Triangle triangle);
+  TriangularMatrix(const TriangularMatrix &rhs);
+  TriangularMatrix(TriangularMatrix &&rhs) noexcept;
+  TriangularMatrix &operator=(const TriangularMatrix &rhs);
+  TriangularMatrix &operator=(TriangularMatrix &&rhs) noexcept;
+  ~TriangularMatrix();
+
+  // Entries outside of the stored triangle are zeros and can not be set
+  double get(size_t row, size_t col) const;
+  void set(size_t row, size_t col, double value);
+
+  size_t getDim() const;
+  Triangle getTriangle() const;
+
+  Matrix operator*(const Matrix &rhs) const;
+  std::vector<double> operator*(const std::vector<double> &x) const;
+
+  // Solves A * x = b by forward / backward substitution, O(n^2)
+  std::vector<double> solve(const std::vector<double> &b) const;
+  // Product of the main diagonal
+  double det() const;
+
+  Matrix toMatrix() const;
+};
+
+// Symmetric matrix declaration,
+// only lower triangle is kept (packed by rows), A[i][j] == A[j][i]
+class SymmetricMatrix {
+private:
+  size_t m_dim = 0;
+  double *m_data = nullptr;
+
+  // Defaults
+  static constexpr size_t default_size = 1;
+  static constexpr double diag_default = 1;
+  static constexpr double off_diag_default = 0;
+
+private:
+  // Free all data
+  void clear();
+
+  size_t index(size_t row, size_t col) const;
+
+  // Bunch-Kaufman P * A * P^T = L * D * L^T into packed storage @ld (unit L
+  // below diagonal, D on it), @perm of P, @block[k] set where a 2x2 block
+  // of D starts. False when a column is zero relative to the largest entry
+  bool factorize(double *ld, size_t *perm, char *block) const;
+
+public:
+  // constructors
+  explicit SymmetricMatrix(size_t dim = default_size,
+                           double diag_value = diag_default,
+                           double off_diag_value = off_diag_default);
+  // Takes the lower triangle of a square dense matrix
+  explicit SymmetricMatrix(const Matrix &dense);
+  SymmetricMatrix(const SymmetricMatrix &rhs);
+  SymmetricMatrix(SymmetricMatrix &&rhs) noexcept;
+  SymmetricMatrix &operator=(const SymmetricMatrix &rhs);
+  SymmetricMatrix &operator=(SymmetricMatrix &&rhs) noexcept;
+  ~SymmetricMatrix();
+
+  // set(i, j, v) updates both A[i][j] and A[j][i]
+  double get(size_t row, size_t col) const;
+  void set(size_t row, size_t col, double value);
+
+  size_t getDim() const;
+
+  Matrix operator*(const Matrix &rhs) const;
+  std::vector<double> operator*(const std::vector<double> &x) const;
+
+  // Solves A * x = b by LDL^T factorization with symmetric pivoting at half
+  // of LU cost in packed storage, indefinite A included,
+  // throws SingularMatrixException
+  std::vector<double> solve(const std::vector<double> &b) const;
+  // Product of D blocks in LDL^T factorization
+  double det() const;
+
+  Matrix toMatrix() const;
+};
+
+// Band matrix declaration,
+// square matrix with @kl subdiagonals and @ku superdiagonals,
+// row i keeps columns [i - kl, i + ku]
+class BandMatrix {
+private:
+  size_t m_dim = 0;
+  size_t m_kl = 0;
+  size_t m_ku = 0;
+  double *m_data = nullptr;
+
+  // Defaults
+  static constexpr size_t default_size = 1;
+  static constexpr double diag_default = 1;
+
+private:
+  // Free all data
+  void clear();
+
+  size_t width() const;
+  size_t index(size_t row, size_t col) const;
+  bool inBand(size_t row, size_t col) const;
+
+  // Gaussian elimination with partial pivoting in band storage,
+  // applied to @rhs simultaneously if given, returns diagonal product
+  double eliminate(std::vector<double> *rhs) const;
+
+public:
+  // constructors
+  explicit BandMatrix(size_t dim = default_size, size_t kl = 0, size_t ku = 0,
+                      double diag_value = diag_default);
+  // Takes the band of a square dense matrix
+  BandMatrix(const Matrix &dense, size_t kl, size_t ku);
+  BandMatrix(const BandMatrix &rhs);
+  BandMatrix(BandMatrix &&rhs) noexcept;
+  BandMatrix &operator=(const BandMatrix &rhs);
+  BandMatrix &operator=(BandMatrix &&rhs) noexcept;
+  ~BandMatrix();
+
+  // Entries outside of the band are zeros and can not be set
+  double get(size_t row, size_t col) const;
+  void set(size_t row, size_t col, double value);
+
+  size_t getDim() const;
+  size_t getLowerBandwidth() const;
+  size_t getUpperBandwidth() const;
+
+  Matrix operator*(const Matrix &rhs) const;
+  std::vector<double> operator*(const std::vector<double> &x) const;
+
+  // Solves A * x = b by banded LU with partial pivoting, O(n * kl * (kl + ku))
+  std::vector<double> solve(const std::vector<double> &b) const;
+  double det() const;
+
+  Matrix toMatrix() const;
+};
+
+}  // namespace task
@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+
+#include "kernels.h"
+#include "matrix.h"
+#include "tuning.h"
+
+using namespace task;
+using namespace task::tuning;
+
+namespace {
+
+std::atomic<size_t> multiply_block{BlockSizes{}.multiply};
+std::atomic<size_t> transpose_block{BlockSizes{}.transpose};
+std::atomic<size_t> lu_block{BlockSizes{}.lu};
+
+// Set once block sizes are final: loaded, tuned or explicitly set
+std::atomic<bool> initialized{false};
+std::mutex init_mutex;
+std::mutex tune_mutex;
+
+// Candidate sizes benchmarked by tune(), seen only by the tuning thread,
+// so other threads keep the stored sizes until the winners are stored
+thread_local BlockSizes *trial = nullptr;
+
+constexpr size_t candidates[] = {8, 16, 32, 64, 128, 256};
+
+// Benchmark sizes, big enough to leave L1, small enough to tune in a blink
+constexpr size_t multiply_dim = 192;
+constexpr size_t transpose_dim = 512;
+constexpr size_t lu_dim = 192;
+constexpr size_t repeats = 3;
+
+BlockSizes current() {
+  BlockSizes sizes;
+  sizes.multiply = multiply_block;
+  sizes.transpose = transpose_block;
+  sizes.lu = lu_block;
+  return sizes;
+}
+
+void store(const BlockSizes &sizes) {
+  multiply_block = std::max<size_t>(1, sizes.multiply);
+  transpose_block = std::max<size_t>(1, sizes.transpose);
+  lu_block = std::max<size_t>(1, sizes.lu);
+}
+
+// Deterministic diagonally dominant test matrix
+Matrix benchmarkMatrix(size_t dim) {
+  Matrix res(dim, dim);
+  for (size_t row = 0; row < dim; row++) {
+    for (size_t col = 0; col < dim; col++) {
+      res[row][col] = static_cast<double>((row * 31 + col * 17) % 13) - 6.;
+    }
+    res[row][row] += 8. * dim;
+  }
+  return res;
+}
+
+// Best of @repeats runs of @op, in seconds
+template <typename Func>
+double bestTime(Func op) {
+  double best = 0;
+  for (size_t r = 0; r < repeats; r++) {
+    const auto start = std::chrono::steady_clock::now();
+    op();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (r == 0 || elapsed.count() < best)
+      best = elapsed.count();
+  }
+  return best;
+}
+
+// Tries every candidate no bigger than @dim in field @block of @sizes,
+// keeps the fastest
+template <typename Func>
+size_t pick(BlockSizes &sizes, size_t BlockSizes::*block, size_t dim, Func op) {
+  size_t winner = sizes.*block;
+  double winner_time = 0;
+  for (size_t candidate : candidates) {
+    if (candidate > dim)
+      break;
+    sizes.*block = candidate;
+    const double time = bestTime(op);
+    if (winner_time == 0 || time < winner_time) {
+      winner = candidate;
+      winner_time = time;
+    }
+  }
+  sizes.*block = winner;
+  return winner;
+}
+
+// Cache is "key value" lines, tuned kernels isa is stored to detect stale cache
+bool loadCache(BlockSizes &sizes) {
+  const std::string path = cachePath();
+  if (path.empty())
+    return false;
+  std::ifstream input(path);
+  std::string key, isa;
+  size_t value;
+  size_t found = 0;
+  while (input >> key) {
+    if (key == "isa") {
+      input >> isa;
+      continue;
+    }
+    if (!(input >> value) || value == 0)
+      return false;
+    if (key == "multiply") {
+      sizes.multiply = value;
+      found++;
+    } else if (key == "transpose") {
+      sizes.transpose = value;
+      found++;
+    } else if (key == "lu") {
+      sizes.lu = value;
+      found++;
+    }
+  }
+  return found == 3 && isa == kernels::active().name;
+}
+
+void saveCache(const BlockSizes &sizes) {
+  const std::string path = cachePath();
+  if (path.empty())
+    return;
+  std::ofstream output(path, std::ios::trunc);
+  output << "isa " << kernels::active().name << "\n"
+         << "multiply " << sizes.multiply << "\n"
+         << "transpose " << sizes.transpose << "\n"
+         << "lu " << sizes.lu << "\n";
+}
+
+// Without a cache path the compiled-in defaults stay, nothing is benchmarked
+// or written. Other threads wait on the lock until the sizes are stored
+void initialize() {
+  std::lock_guard<std::mutex> lock(init_mutex);
+  if (initialized)
+    return;
+  BlockSizes sizes;
+  if (loadCache(sizes))
+    store(sizes);
+  else if (!cachePath().empty())
+    tune();
+  initialized = true;
+}
+
+}  // namespace
+
+BlockSizes task::tuning::blockSizes() {
+  if (trial)
+    return *trial;
+  if (!initialized)
+    initialize();
+  return current();
+}
+
+void task::tuning::setBlockSizes(const BlockSizes &sizes) {
+  store(sizes);
+  initialized = true;
+}
+
+BlockSizes task::tuning::tune() {
+  std::lock_guard<std::mutex> lock(tune_mutex);
+
+  const Matrix square = benchmarkMatrix(multiply_dim);
+  const Matrix wide = benchmarkMatrix(transpose_dim);
+  const Matrix system = benchmarkMatrix(lu_dim);
+  volatile double sink = 0;
+
+  BlockSizes sizes = current();
+  struct TrialScope {
+    explicit TrialScope(BlockSizes &sizes) {
+      trial = &sizes;
+    }
+    ~TrialScope() {
+      trial = nullptr;
+    }
+  } scope(sizes);
+  pick(sizes, &BlockSizes::multiply, multiply_dim, [&] { sink = sink + (square * square)[0][0]; });
+  pick(sizes, &BlockSizes::transpose, transpose_dim,
+       [&] { sink = sink + wide.transposed()[0][0]; });
+  pick(sizes, &BlockSizes::lu, lu_dim, [&] { sink = sink + system.det(); });
+
+  store(sizes);
+  initialized = true;
+  saveCache(sizes);
+  return sizes;
+}
+
+std::string task::tuning::cachePath() {
+  const char *path = std::getenv("MATRIX_TUNE_CACHE");
+  return path ? path : "";
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <string>
+
+
+namespace task {
+namespace tuning {
+
+// Tile sizes of blocked Matrix kernels
+struct BlockSizes {
+  size_t multiply = 64;   // i / k / j tiles of operator*
+  size_t transpose = 32;  // square tiles of transposed()
+  size_t lu = 32;         // panel width of LU factorization in det()
+};
+
+// Block sizes in use, the defaults above unless a cache file is set:
+// then on first call they are read from it, and if it is missing (or was
+// tuned for other kernels) tune() runs once. Concurrent first calls wait
+// until the sizes are final
+BlockSizes blockSizes();
+
+// Override block sizes for this process, cache file is not touched
+void setBlockSizes(const BlockSizes &sizes);
+
+// Benchmark candidate block sizes on this host, apply the winners
+// and store them into the cache file if one is set. Candidates are seen
+// only by the calling thread, others switch to the winners when it ends
+BlockSizes tune();
+
+// Cache file path: MATRIX_TUNE_CACHE environment variable, empty when it
+// is not set (no cache file, no tuning on first use)
+std::string cachePath();
+
+}  // namespace tuning
+}  // namespace task
@@ -4,7 +4,16 @@
 #include <algorithm>
 #include <sstream>
 #include <cmath>
+#include <fstream>
+#include <type_traits>
+#include "src/eigen.h"
+#include "src/exact_det.h"
+#include "src/kernels.h"
 #include "src/matrix.h"
+#include "src/out_of_core.h"
+#include "src/rank_one.h"
+#include "src/structured_matrix.h"
+#include "src/tuning.h"
 
 
 using task::Matrix;
@@ -208,6 +217,444 @@ int main(int argc, char** argv) {
     }
 
 
+    REPEAT(10)
+    {
+        size_t n = RandomUInt(1, 50);
+        // diagonally dominant to keep solvers well-conditioned
+        auto dense = RandomMatrix(n, n) + Matrix(n, n, 20. * n);
+        auto rhs = RandomMatrix(n, RandomUInt(1, 10));
+        std::vector<double> b = RandomMatrix(1, n).getRow(0);
+
+        task::TriangularMatrix upper(dense, task::Triangle::Upper);
+        task::TriangularMatrix lower(dense, task::Triangle::Lower);
+        for (const auto& tri : {upper, lower}) {
+            Matrix full = tri.toMatrix();
+            ASSERT_TRUE_MSG(tri * rhs == full * rhs, "Triangular operator *")
+            ASSERT_TRUE_MSG(fabs(tri.det() - full.det()) < EPS * fabs(full.det()) + EPS, "Triangular det()")
+            auto x = tri.solve(b);
+            auto bx = tri * x;
+            for (size_t i = 0; i < n; ++i) {
+                ASSERT_TRUE_MSG(fabs(bx[i] - b[i]) < EPS, "Triangular solve()")
+            }
+        }
+        ASSERT_EXCEPTION_MSG(upper.set(n, 0, 1.), task::OutOfBoundsException, "Triangular set()")
+        if (n > 1) {
+            ASSERT_EXCEPTION_MSG(upper.set(n - 1, 0, 1.), task::OutOfBoundsException, "Triangular set()")
+        }
+
+        Matrix sym_dense = dense + dense.transposed();
+        task::SymmetricMatrix sym(sym_dense);
+        ASSERT_TRUE_MSG(sym.toMatrix() == sym_dense, "Symmetric storage")
+        ASSERT_TRUE_MSG(sym * rhs == sym_dense * rhs, "Symmetric operator *")
+        ASSERT_TRUE_MSG(fabs(sym.det() - sym_dense.det()) < 1e-9 * fabs(sym_dense.det()) + EPS, "Symmetric det()")
+        auto sx = sym * sym.solve(b);
+        for (size_t i = 0; i < n; ++i) {
+            ASSERT_TRUE_MSG(fabs(sx[i] - b[i]) < EPS, "Symmetric solve()")
+        }
+
+        // random symmetric matrices are indefinite and take 2x2 pivots
+        Matrix random_dense = RandomMatrix(n, n);
+        Matrix indefinite_dense = random_dense + random_dense.transposed();
+        task::SymmetricMatrix indefinite(indefinite_dense);
+        const double indefinite_det = indefinite_dense.det();
+        ASSERT_TRUE_MSG(fabs(indefinite.det() - indefinite_det) < 1e-9 * fabs(indefinite_det) + EPS, "Symmetric indefinite det()")
+        std::vector<double> expected_x = RandomMatrix(1, n).getRow(0);
+        auto ix = indefinite.solve(indefinite * expected_x);
+        auto ib = indefinite * ix, expected_b = indefinite * expected_x;
+        for (size_t i = 0; i < n; ++i) {
+            ASSERT_TRUE_MSG(fabs(ib[i] - expected_b[i]) < 1e-6 * (1. + fabs(expected_b[i])), "Symmetric indefinite solve()")
+        }
+
+        size_t kl = RandomUInt(0, n - 1), ku = RandomUInt(0, n - 1);
+        task::BandMatrix band(dense, kl, ku);
+        Matrix band_dense = band.toMatrix();
+        ASSERT_TRUE_MSG(band * rhs == band_dense * rhs, "Band operator *")
+        ASSERT_TRUE_MSG(fabs(band.det() - band_dense.det()) < 1e-9 * fabs(band_dense.det()) + EPS, "Band det()")
+        auto bandx = band * band.solve(b);
+        for (size_t i = 0; i < n; ++i) {
+            ASSERT_TRUE_MSG(fabs(bandx[i] - b[i]) < EPS, "Band solve()")
+        }
+        ASSERT_EXCEPTION_MSG(band.solve({}), task::SizeMismatchException, "Band solve()")
+    }
+
+    {
+        // indefinite symmetric matrix requires pivoting
+        task::SymmetricMatrix sym(2, 0., 1.);
+        ASSERT_TRUE_MSG(fabs(sym.det() + 1.) < EPS, "Symmetric det()")
+        auto x = sym.solve({2., 3.});
+        ASSERT_TRUE_MSG(fabs(x[0] - 3.) < EPS && fabs(x[1] - 2.) < EPS, "Symmetric solve()")
+
+        // small leading pivot of an indefinite matrix, without pivoting the
+        // multipliers of 5e11 leave d_3 to cancellation of huge terms
+        task::SymmetricMatrix small_pivot(3, 1., 1.);
+        small_pivot.set(0, 0, 2e-12);
+        small_pivot.set(1, 1, 0.7);
+        small_pivot.set(2, 2, 0.3);
+        small_pivot.set(1, 2, 2.);
+        auto px = small_pivot.solve(small_pivot * std::vector<double>{0.1, 0.2, 0.3});
+        ASSERT_TRUE_MSG(fabs(px[0] - 0.1) < 1e-12 && fabs(px[1] - 0.2) < 1e-12 && fabs(px[2] - 0.3) < 1e-12,
+                        "Symmetric solve() small pivot")
+        const double small_pivot_det = small_pivot.toMatrix().det();
+        ASSERT_TRUE_MSG(fabs(small_pivot.det() - small_pivot_det) < 1e-12, "Symmetric det() small pivot")
+
+        // well-conditioned positive definite matrix of tiny scale
+        task::SymmetricMatrix tiny(3, 4e-14, 1e-14);
+        auto tx = tiny * tiny.solve({1e-14, 2e-14, 3e-14});
+        ASSERT_TRUE_MSG(fabs(tx[0] - 1e-14) < 1e-22 && fabs(tx[2] - 3e-14) < 1e-22, "Symmetric solve() tiny scale")
+        // 1e-14 * (3 I + J), eigenvalues 3, 3 and 6
+        ASSERT_TRUE_MSG(fabs(tiny.det() / 54e-42 - 1.) < 1e-9, "Symmetric det() tiny scale")
+
+        task::TriangularMatrix singular(3, task::Triangle::Lower, 0.);
+        ASSERT_EXCEPTION_MSG(singular.solve({1., 1., 1.}), task::SingularMatrixException, "Triangular solve()")
+        ASSERT_EXCEPTION_MSG(task::SymmetricMatrix(3, 0., 0.).solve({1., 1., 1.}), task::SingularMatrixException, "Symmetric solve()")
+        ASSERT_TRUE_MSG(task::SymmetricMatrix(3, 1., 1.).det() == 0., "Symmetric singular det()")
+
+        // 2x2 pivot on a zero diagonal, D = [[0, 1], [1, 0]] then 1x1 pivot
+        task::SymmetricMatrix saddle(3, 0., 1.);
+        saddle.set(2, 2, 5.);
+        const double saddle_det = saddle.toMatrix().det();
+        ASSERT_TRUE_MSG(fabs(saddle.det() - saddle_det) < 1e-12, "Symmetric det() 2x2 pivot")
+        auto sdx = saddle.solve(saddle * std::vector<double>{1., 2., 3.});
+        ASSERT_TRUE_MSG(fabs(sdx[0] - 1.) < 1e-12 && fabs(sdx[1] - 2.) < 1e-12 && fabs(sdx[2] - 3.) < 1e-12,
+                        "Symmetric solve() 2x2 pivot")
+
+        // singularity thresholds are relative, well-conditioned matrices of tiny scale solve
+        task::TriangularMatrix tiny_tri(3, task::Triangle::Lower, 1e-13);
+        tiny_tri.set(2, 0, 1e-13);
+        auto ttx = tiny_tri.solve({1e-13, 2e-13, 4e-13});
+        ASSERT_TRUE_MSG(fabs(ttx[0] - 1.) < 1e-12 && fabs(ttx[1] - 2.) < 1e-12 && fabs(ttx[2] - 3.) < 1e-12,
+                        "Triangular solve() tiny scale")
+        task::BandMatrix tiny_band(3, 1, 1, 2e-13);
+        tiny_band.set(1, 0, 1e-13);
+        auto tbx = tiny_band.solve({2e-13, 1e-13, 2e-13});
+        ASSERT_TRUE_MSG(fabs(tbx[0] - 1.) < 1e-12 && fabs(tbx[1]) < 1e-12 && fabs(tbx[2] - 1.) < 1e-12,
+                        "Band solve() tiny scale")
+        task::BandMatrix nearly_singular(2, 0, 0, 1.);
+        nearly_singular.set(1, 1, 1e-13);
+        ASSERT_EXCEPTION_MSG(nearly_singular.solve({1., 1.}), task::SingularMatrixException, "Band solve() relative pivot")
+    }
+
+
+    {
+        namespace kernels = task::kernels;
+        const auto& generic = kernels::table(kernels::Isa::Generic);
+        for (auto isa : {kernels::Isa::Sse42, kernels::Isa::Avx2, kernels::Isa::Avx512}) {
+            if (!kernels::supported(isa)) {
+                continue;
+            }
+            const auto& table = kernels::table(isa);
+            for (size_t n : {0, 1, 3, 7, 8, 13, 64, 101}) {
+                std::vector<double> x, y, expected;
+                for (size_t i = 0; i < n; ++i) {
+                    x.push_back(RandomDouble());
+                    y.push_back(RandomDouble());
+                }
+                double alpha = RandomDouble();
+
+                expected = y;
+                generic.axpy(n, alpha, x.data(), expected.data());
+                table.axpy(n, alpha, x.data(), y.data());
+                for (size_t i = 0; i < n; ++i) {
+                    ASSERT_TRUE_MSG(fabs(expected[i] - y[i]) < EPS, table.name)
+                }
+
+                generic.add(n, x.data(), expected.data());
+                table.add(n, x.data(), y.data());
+                generic.sub(n, x.data(), expected.data());
+                table.sub(n, x.data(), y.data());
+                generic.scale(n, alpha, expected.data());
+                table.scale(n, alpha, y.data());
+                for (size_t i = 0; i < n; ++i) {
+                    ASSERT_TRUE_MSG(fabs(expected[i] - y[i]) < EPS, table.name)
+                }
+            }
+        }
+    }
+
+
+    REPEAT(10)
+    {
+        size_t n = RandomUInt(1, 30);
+        auto mat = RandomMatrix(n, n) + Matrix(n, n, 20. * n);
+        task::RankOneUpdater updater(mat, RandomUInt(1, 2 * n));
+
+        REPEAT(3 * n)
+        {
+            std::vector<double> u = RandomMatrix(1, n).getRow(0);
+            std::vector<double> v = RandomMatrix(1, n).getRow(0);
+            updater.update(u, v);
+            for (size_t i = 0; i < n; ++i) {
+                for (size_t j = 0; j < n; ++j) {
+                    mat[i][j] += u[i] * v[j];
+                }
+            }
+        }
+
+        ASSERT_TRUE_MSG(updater.getMatrix() == mat, "Rank-1 update")
+        double det = mat.det();
+        ASSERT_TRUE_MSG(fabs(updater.det() - det) < 1e-9 * fabs(det), "Rank-1 update det()")
+        ASSERT_TRUE_MSG(updater.getInverse() * mat == Matrix(n, n), "Rank-1 update inverse")
+    }
+
+    {
+        // update making matrix singular must keep state untouched
+        task::RankOneUpdater updater(Matrix(2, 2));
+        ASSERT_EXCEPTION_MSG(updater.update({-1., 0.}, {1., 0.}), task::SingularMatrixException, "Rank-1 update")
+        ASSERT_TRUE_MSG(updater.getMatrix() == Matrix(2, 2) && updater.det() == 1., "Rank-1 update")
+        ASSERT_EXCEPTION_MSG(updater.update({1.}, {1., 0.}), task::SizeMismatchException, "Rank-1 update")
+    }
+
+
+    REPEAT(5)
+    {
+        size_t n = RandomUInt(1, 60), m = RandomUInt(1, 60), k = RandomUInt(1, 60);
+        auto mat1 = RandomMatrix(n, m);
+        auto mat2 = RandomMatrix(m, k);
+
+        auto a = task::MatrixFile::save("ooc_a.bin", mat1);
+        auto b = task::MatrixFile::save("ooc_b.bin", mat2);
+        auto c = task::MatrixFile::create("ooc_c.bin", n, k);
+        ASSERT_TRUE_MSG(task::MatrixFile("ooc_a.bin").load() == mat1, "MatrixFile save / load")
+
+        // a few KB budget forces many small tiles
+        auto stats = task::multiplyOutOfCore(a, b, c, RandomUInt(64, 8192));
+        ASSERT_TRUE_MSG(stats.tile_size >= 1 && stats.tiles_written > 0, "Out-of-core multiply stats")
+        ASSERT_TRUE_MSG(c.load() == mat1 * mat2, "Out-of-core multiply")
+
+        ASSERT_EXCEPTION_MSG(task::multiplyOutOfCore(a, a, c, 1024), task::SizeMismatchException, "Out-of-core multiply")
+
+        std::remove("ooc_a.bin");
+        std::remove("ooc_b.bin");
+        std::remove("ooc_c.bin");
+    }
+    ASSERT_EXCEPTION_MSG(task::MatrixFile("ooc_missing.bin"), task::FileAccessException, "MatrixFile")
+
+
+    REPEAT(20)
+    {
+        size_t n = RandomUInt(1, 6);
+        Matrix mat(n, n);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                mat[i][j] = static_cast<double>(RandomUInt(0, 20)) - 10.;
+            }
+        }
+        auto det = task::detExact(mat);
+        ASSERT_TRUE_MSG(det.fitsInt128(), "Exact det()")
+        // pivoted band LU over the full matrix as floating-point reference
+        double reference = task::BandMatrix(mat, n - 1, n - 1).det();
+        ASSERT_TRUE_MSG(det.toInt128() == static_cast<__int128>(std::llround(reference)), "Exact det()")
+    }
+
+    {
+        // det = 1000^20 overflows int128, unimodular row operations keep it
+        const size_t n = 20;
+        Matrix mat(n, n, 1000.);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = i + 1; j < n; ++j) {
+                mat[i][j] = static_cast<double>(RandomUInt(0, 6)) - 3.;
+            }
+        }
+        for (size_t i = 1; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                mat[i][j] += (i % 3 == 0 ? -1. : 1.) * mat[i - 1][j];
+            }
+        }
+        auto det = task::detExact(mat);
+        ASSERT_TRUE_MSG(!det.fitsInt128(), "Exact det()")
+        ASSERT_TRUE_MSG(det.toString() == "1" + std::string(60, '0'), "Exact det()")
+
+        for (size_t j = 0; j < n; ++j) {
+            std::swap(mat[0][j], mat[1][j]);
+        }
+        ASSERT_TRUE_MSG(task::detExact(mat).toString() == "-1" + std::string(60, '0'), "Exact det()")
+
+        mat[3][4] = 0.5;
+        ASSERT_EXCEPTION_MSG(task::detExact(mat), task::NonIntegerMatrixException, "Exact det()")
+        ASSERT_TRUE_MSG(task::detExact(Matrix(3, 3, 0.)).isZero(), "Exact det()")
+    }
+
+
+    {
+        // blocked kernels must not depend on block sizes
+        size_t n = RandomUInt(50, 150), m = RandomUInt(50, 150);
+        auto mat1 = RandomMatrix(n, m);
+        auto mat2 = RandomMatrix(m, n);
+        auto square = RandomMatrix(n, n);
+
+        Matrix product(n, n, 0.), transposed(m, n, 0.);
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j < n; ++j) {
+                for (size_t s = 0; s < m; ++s) {
+                    product[i][j] += mat1[i][s] * mat2[s][j];
+                }
+            }
+            for (size_t j = 0; j < m; ++j) {
+                transposed[j][i] = mat1[i][j];
+            }
+        }
+        double det = square.det();
+
+        const auto saved = task::tuning::blockSizes();
+        for (size_t block : {1, 3, 16, 64, 1000}) {
+            task::tuning::setBlockSizes({block, block, block});
+            ASSERT_TRUE_MSG(mat1 * mat2 == product, "Blocked operator *")
+            ASSERT_TRUE_MSG(mat1.transposed() == transposed, "Blocked transposed()")
+            ASSERT_TRUE_MSG(fabs(square.det() - det) < 1e-9 * fabs(det), "Blocked det()")
+        }
+        task::tuning::setBlockSizes(saved);
+
+        setenv("MATRIX_TUNE_CACHE", "tune_test.cache", 1);
+        auto tuned = task::tuning::tune();
+        std::ifstream cache("tune_test.cache");
+        std::string key;
+        size_t value = 0, found = 0;
+        while (cache >> key) {
+            if (key == "isa") {
+                cache >> key;
+                continue;
+            }
+            cache >> value;
+            found += (key == "multiply" && value == tuned.multiply) ||
+                     (key == "transpose" && value == tuned.transpose) ||
+                     (key == "lu" && value == tuned.lu);
+        }
+        ASSERT_TRUE_MSG(found == 3, "Tuning cache")
+        std::remove("tune_test.cache");
+        unsetenv("MATRIX_TUNE_CACHE");
+        ASSERT_TRUE_MSG(task::tuning::cachePath().empty(), "Tuning cache is opt-in")
+    }
+
+
+    {
+        // copies are deep by default, views taken before a copy never write into it
+        auto plain = RandomMatrix(20, 20);
+        auto plain_row = plain[3];
+        Matrix plain_copy = plain;
+        plain_row[4] += 1.;
+        ASSERT_TRUE_MSG(!plain.copyOnWrite() && !plain.isShared() && !plain_copy.isShared(), "Deep copy")
+        ASSERT_TRUE_MSG(plain_copy.get(3, 4) == plain.get(3, 4) - 1., "Deep copy")
+
+        // in copy-on-write mode copies share data until the first modification
+        auto mat1 = RandomMatrix(50, 40);
+        mat1.setCopyOnWrite(true);
+        const double value = mat1.get(3, 4);
+        Matrix mat2 = mat1;
+        Matrix mat3;
+        mat3 = mat2;
+        ASSERT_TRUE_MSG(mat1.isShared() && mat2.isShared() && mat3.isShared(), "Copy-on-write")
+        ASSERT_TRUE_MSG(mat2.copyOnWrite() && !mat3.copyOnWrite(), "Copy-on-write mode")
+
+        const Matrix& const_ref = mat2;
+        ASSERT_TRUE_MSG(const_ref[3][4] == value && const_ref.get(3, 4) == value, "Copy-on-write")
+        ASSERT_TRUE_MSG(mat2.isShared(), "Copy-on-write")
+        // rows of a const matrix give no write access into the shared buffer
+        using ConstRow = decltype(const_ref[0]);
+        static_assert(!std::is_constructible<task::RowView, ConstRow>::value, "Copy-on-write");
+        static_assert(!std::is_assignable<decltype(const_ref[0][0]), double>::value, "Copy-on-write");
+
+        mat2.set(3, 4, value + 1.);
+        ASSERT_TRUE_MSG(!mat2.isShared() && mat1.isShared(), "Copy-on-write")
+        ASSERT_TRUE_MSG(mat1.get(3, 4) == value && mat3.get(3, 4) == value, "Copy-on-write")
+        ASSERT_TRUE_MSG(mat2.get(3, 4) == value + 1., "Copy-on-write")
+
+        mat3[0][0] += 1.;
+        ASSERT_TRUE_MSG(!mat1.isShared() && !mat3.isShared(), "Copy-on-write")
+
+        Matrix mat4 = mat1;
+        mat4 *= 2.;
+        ASSERT_TRUE_MSG(mat4.get(3, 4) == 2. * value && mat1.get(3, 4) == value, "Copy-on-write")
+        mat4 = mat1;
+        mat4 += mat1;
+        ASSERT_TRUE_MSG(mat4.get(3, 4) == 2. * value && mat1.get(3, 4) == value, "Copy-on-write")
+        mat4 = mat1;
+        mat4.resize(10, 10);
+        ASSERT_TRUE_MSG(mat1.getRows() == 50 && mat1.get(3, 4) == value, "Copy-on-write")
+
+        // copies of a matrix out of the mode are deep, turning it off detaches
+        Matrix mat5 = mat3;
+        ASSERT_TRUE_MSG(!mat5.isShared() && !mat5.copyOnWrite(), "Copy-on-write mode")
+        Matrix mat6 = mat1;
+        mat6.setCopyOnWrite(false);
+        ASSERT_TRUE_MSG(!mat6.isShared() && mat6.get(3, 4) == value, "Copy-on-write mode")
+    }
+
+
+    {
+        // symmetric eigen decomposition: A * v = lambda * v, V^T * V = I
+        for (size_t n : {1, 2, 7, 40, 130}) {
+            auto mat = RandomMatrix(n, n);
+            Matrix sym = mat + mat.transposed();
+            for (auto method : {task::EigenMethod::Jacobi, task::EigenMethod::Tridiagonal}) {
+                task::EigenOptions options;
+                options.method = method;
+                auto result = task::symmetricEigen(sym, options);
+                ASSERT_TRUE_MSG(result.converged && result.values.size() == n, "Symmetric eigen")
+                ASSERT_TRUE_MSG(std::is_sorted(result.values.begin(), result.values.end()), "Symmetric eigen")
+
+                double scale = 1.;
+                for (double value : result.values)
+                    scale = std::max(scale, fabs(value));
+                Matrix av = sym * result.vectors;
+                Matrix vtv = result.vectors.transposed() * result.vectors;
+                double residual = 0, orthogonality = 0;
+                for (size_t row = 0; row < n; row++) {
+                    for (size_t col = 0; col < n; col++) {
+                        residual = std::max(residual, fabs(av[row][col] - result.values[col] * result.vectors[row][col]));
+                        orthogonality = std::max(orthogonality, fabs(vtv[row][col] - (row == col ? 1. : 0.)));
+                    }
+                }
+                ASSERT_TRUE_MSG(residual < 1e-10 * scale, "Symmetric eigen residual")
+                ASSERT_TRUE_MSG(orthogonality < 1e-10, "Symmetric eigen orthogonality")
+            }
+        }
+
+        task::SymmetricMatrix packed(3);
+        packed.set(0, 0, 2.);
+        packed.set(1, 1, 3.);
+        packed.set(2, 2, 1.);
+        packed.set(1, 0, 1.);
+        auto result = task::symmetricEigen(packed);
+        ASSERT_TRUE_MSG(fabs(result.values[0] - 1.) < 1e-12, "Symmetric eigen packed")
+        ASSERT_TRUE_MSG(fabs(result.values[1] + result.values[2] - 5.) < 1e-12, "Symmetric eigen packed")
+        ASSERT_TRUE_MSG(fabs(result.values[1] * result.values[2] - 5.) < 1e-12, "Symmetric eigen packed")
+    }
+
+
+    {
+        // inverse: A * A^{-1} = I, storage of destination is reused
+        for (size_t n : {1, 5, 33, 150}) {
+            Matrix mat = RandomMatrix(n, n) + Matrix(n, n, 10. * n);
+            Matrix inverse(n, n);
+            double det = 0;
+            const double rcond = mat.inverse(inverse, &det);
+            ASSERT_TRUE_MSG(rcond > 0. && rcond <= 1., "Inverse condition")
+            ASSERT_TRUE_MSG(std::isinf(det) || fabs(det - mat.det()) <= 1e-9 * fabs(det), "Inverse det")
+            Matrix product = mat * inverse;
+            double error = 0;
+            for (size_t row = 0; row < n; row++) {
+                for (size_t col = 0; col < n; col++)
+                    error = std::max(error, fabs(product[row][col] - (row == col ? 1. : 0.)));
+            }
+            ASSERT_TRUE_MSG(error < 1e-10, "Inverse")
+            ASSERT_TRUE_MSG(mat.inverted() == inverse, "Inverse")
+        }
+
+        Matrix mat = RandomMatrix(3, 3) + Matrix(3, 3, 30.);
+        Matrix expected = mat.inverted();
+        mat.inverse(mat);
+        ASSERT_TRUE_MSG(mat == expected, "Inverse in place")
+
+        Matrix ill(2, 2);
+        ill[0][1] = 1.;
+        ill[1][0] = 1.;
+        ill[1][1] = 1. + 1e-13;
+        ASSERT_TRUE_MSG(ill.inverse(mat) < 1e-12, "Inverse condition")
+        ASSERT_EXCEPTION_MSG(Matrix(2, 2, 1., 1.).inverted(), task::SingularMatrixException, "Inverse")
+        ASSERT_EXCEPTION_MSG(Matrix(2, 3).inverted(), task::SizeMismatchException, "Inverse")
+    }
+
+
     const int STRESS_TEST_COUNT = argc > 1 ? std::stoi(argv[1]) : 0;
 
     REPEAT(STRESS_TEST_COUNT)
@@ -0,0 +1,9 @@
+#!/bin/bash
+
+# Usage: ./bench.sh [vector_ops_bench options], see ./bench.sh --help
+# Compare two runs: ./bench.sh --compare old.json new.json
+
+set -e
+
+g++ -std=c++17 -O2 -pthread -I./ bench/bench.cpp -o vector_ops_bench
+./vector_ops_bench "$@"
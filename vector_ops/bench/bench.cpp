@@ -0,0 +1,595 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <numeric>
+#include <random>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "src/vector_ops.h"
+
+using namespace task;
+
+namespace {
+
+// Every result is the median of @samples timed batches, a batch repeats
+// the operation until it takes at least @min_batch_seconds
+constexpr size_t samples = 7;
+constexpr double min_batch_seconds = 2e-3;
+// Batches of huge sizes are single runs, sampling stops after this budget
+constexpr double max_op_seconds = 10.;
+
+const char *const known_ops[] = {"dot", "cross",     "add",     "sub",   "or",
+                                 "and", "collinear", "reverse", "print", "parse"};
+const char *const known_types[] = {"int", "float", "double"};
+
+struct Options {
+  size_t min_size = 3;
+  size_t max_size = 1000000;
+  std::vector<std::string> ops = {known_ops, known_ops + std::size(known_ops)};
+  std::vector<std::string> types = {known_types, known_types + std::size(known_types)};
+  std::string json = "bench_output.json";
+  double threshold = 0.05;
+  std::string compare_old, compare_new;
+};
+
+struct Result {
+  std::string op;
+  std::string type;
+  // "api" is the vector_ops call, "raw" a plain loop into preallocated
+  // storage, "std" the standard algorithm, "soa" the batched Vec3Array,
+  // "to_chars" the buffer based text API (formatTo / parseText)
+  std::string variant;
+  size_t size = 0;
+  double ns_per_element = 0;
+  // fastest sample per element, less sensitive to interference than the median
+  double best_ns = 0;
+  double gbps = 0;
+  // relative standard deviation of samples, used as noise estimate
+  double noise = 0;
+  size_t reps = 0;
+};
+
+struct Workload {
+  std::string variant;
+  std::function<void()> run;
+  double bytes;
+};
+
+volatile double sink = 0;
+
+double seconds(std::chrono::steady_clock::duration duration) {
+  return std::chrono::duration<double>(duration).count();
+}
+
+const char *isaName(task::simd::Isa isa) {
+  switch (isa) {
+    case task::simd::Isa::Avx2:
+      return "avx2";
+    case task::simd::Isa::Sse2:
+      return "sse2";
+    case task::simd::Isa::Generic:
+      return "generic";
+  }
+  return "unknown";
+}
+
+Result measure(const std::string &op, const std::string &type, size_t size,
+               const Workload &work) {
+  using clock = std::chrono::steady_clock;
+  // warm up and calibrate the batch length
+  auto start = clock::now();
+  work.run();
+  const double once = std::max(seconds(clock::now() - start), 1e-9);
+  const size_t batch = std::max<size_t>(1, static_cast<size_t>(min_batch_seconds / once));
+
+  std::vector<double> times;
+  double total = 0;
+  while (times.size() < samples && (times.empty() || total < max_op_seconds)) {
+    start = clock::now();
+    for (size_t i = 0; i < batch; i++)
+      work.run();
+    const double elapsed = seconds(clock::now() - start);
+    times.push_back(elapsed / batch);
+    total += elapsed;
+  }
+
+  std::vector<double> sorted = times;
+  std::sort(sorted.begin(), sorted.end());
+  const double median = sorted[sorted.size() / 2];
+  double mean = 0, variance = 0;
+  for (double t : times)
+    mean += t / times.size();
+  for (double t : times)
+    variance += (t - mean) * (t - mean) / times.size();
+
+  Result res;
+  res.op = op;
+  res.type = type;
+  res.variant = work.variant;
+  res.size = size;
+  res.ns_per_element = median * 1e9 / size;
+  res.best_ns = sorted.front() * 1e9 / size;
+  res.gbps = work.bytes / median * 1e-9;
+  res.noise = mean > 0 ? std::sqrt(variance) / mean : 0;
+  res.reps = batch * times.size();
+  return res;
+}
+
+/**
+ * Operands of one element type and size, built once per size and shared
+ * by all variants. Vec3Array copies exist only when cross is measured
+ */
+template <typename T>
+struct Data {
+  std::vector<T> lhs, rhs, scaled, out;
+  task::Vec3Array<T> lhs3, rhs3, out3;
+  std::string text;
+  // preallocated output of the raw print loop
+  std::vector<char> chars;
+
+  Data(size_t size, const Options &options, std::mt19937_64 &rand) {
+    std::uniform_real_distribution<double> dist{-1000., 1000.};
+    lhs.resize(size);
+    rhs.resize(size);
+    for (size_t i = 0; i < size; i++) {
+      lhs[i] = T(dist(rand));
+      rhs[i] = T(dist(rand));
+    }
+    // collinear operands, so the check scans the whole vector
+    scaled = lhs;
+    for (T &value : scaled)
+      value *= 2;
+    out.resize(size);
+    if (has(options, "cross")) {
+      const size_t n = size / 3;
+      lhs3.resize(n);
+      rhs3.resize(n);
+      for (size_t i = 0; i < n; i++) {
+        lhs3.set(i, {lhs[3 * i], lhs[3 * i + 1], lhs[3 * i + 2]});
+        rhs3.set(i, {rhs[3 * i], rhs[3 * i + 1], rhs[3 * i + 2]});
+      }
+    }
+    if (has(options, "print") || has(options, "parse")) {
+      text = std::to_string(size) + " ";
+      task::formatTo(text, lhs);
+      chars.resize(size * 32 + 1);
+    }
+  }
+
+  static bool has(const Options &options, const char *op) {
+    return std::find(options.ops.begin(), options.ops.end(), op) != options.ops.end();
+  }
+};
+
+// Bytes are the compulsory traffic: operands read once, result written once.
+// For parse and print it is the text length
+template <typename T>
+std::vector<Workload> workloads(const std::string &op, Data<T> &data) {
+  const std::vector<T> &lhs = data.lhs, &rhs = data.rhs;
+  std::vector<T> &out = data.out;
+  const size_t n = lhs.size();
+  const double bytes = n * sizeof(T);
+
+  if (op == "dot") {
+    return {{"raw",
+             [&] {
+               double res = 0;
+               for (size_t i = 0; i < lhs.size(); i++)
+                 res += double(lhs[i]) * double(rhs[i]);
+               sink = sink + res;
+             },
+             2 * bytes},
+            {"std",
+             [&] { sink = sink + std::inner_product(lhs.begin(), lhs.end(), rhs.begin(), 0.); },
+             2 * bytes},
+            {"api", [&] { sink = sink + lhs * rhs; }, 2 * bytes}};
+  }
+  if (op == "cross") {
+    // size / 3 vectors, flat triples for raw and api, Vec3Array for soa
+    const size_t count = n / 3;
+    return {{"raw",
+             [&, count] {
+               for (size_t k = 0; k < 3 * count; k += 3) {
+                 out[k] = lhs[k + 1] * rhs[k + 2] - lhs[k + 2] * rhs[k + 1];
+                 out[k + 1] = lhs[k + 2] * rhs[k] - lhs[k] * rhs[k + 2];
+                 out[k + 2] = lhs[k] * rhs[k + 1] - lhs[k + 1] * rhs[k];
+               }
+               sink = sink + out[0];
+             },
+             3 * bytes},
+            {"api",
+             [&, count] {
+               for (size_t k = 0; k < 3 * count; k += 3) {
+                 const std::vector<T> res = Span<const T>(lhs.data() + k, 3) %
+                                            Span<const T>(rhs.data() + k, 3);
+                 std::copy(res.begin(), res.end(), out.begin() + k);
+               }
+               sink = sink + out[0];
+             },
+             3 * bytes},
+            {"soa",
+             [&] {
+               task::cross(data.out3, data.lhs3, data.rhs3);
+               sink = sink + data.out3.x()[0];
+             },
+             3 * bytes}};
+  }
+  if (op == "add" || op == "sub") {
+    const bool add = op == "add";
+    return {{"raw",
+             [&, add] {
+               if (add) {
+                 for (size_t i = 0; i < lhs.size(); i++)
+                   out[i] = lhs[i] + rhs[i];
+               } else {
+                 for (size_t i = 0; i < lhs.size(); i++)
+                   out[i] = lhs[i] - rhs[i];
+               }
+               sink = sink + out[0];
+             },
+             3 * bytes},
+            {"std",
+             [&, add] {
+               if (add)
+                 std::transform(lhs.begin(), lhs.end(), rhs.begin(), out.begin(), std::plus<T>());
+               else
+                 std::transform(lhs.begin(), lhs.end(), rhs.begin(), out.begin(), std::minus<T>());
+               sink = sink + out[0];
+             },
+             3 * bytes},
+            {"api", [&, add] { sink = sink + (add ? lhs + rhs : lhs - rhs)[0]; }, 3 * bytes}};
+  }
+  if (op == "or" || op == "and") {
+    if constexpr (std::is_integral<T>::value) {
+      const bool is_or = op == "or";
+      return {{"raw",
+               [&, is_or] {
+                 if (is_or) {
+                   for (size_t i = 0; i < lhs.size(); i++)
+                     out[i] = lhs[i] | rhs[i];
+                 } else {
+                   for (size_t i = 0; i < lhs.size(); i++)
+                     out[i] = lhs[i] & rhs[i];
+                 }
+                 sink = sink + out[0];
+               },
+               3 * bytes},
+              {"std",
+               [&, is_or] {
+                 if (is_or)
+                   std::transform(lhs.begin(), lhs.end(), rhs.begin(), out.begin(),
+                                  std::bit_or<T>());
+                 else
+                   std::transform(lhs.begin(), lhs.end(), rhs.begin(), out.begin(),
+                                  std::bit_and<T>());
+                 sink = sink + out[0];
+               },
+               3 * bytes},
+              {"api", [&, is_or] { sink = sink + (is_or ? lhs | rhs : lhs & rhs)[0]; }, 3 * bytes}};
+    }
+    // bitwise operators are defined for integers only
+    return {};
+  }
+  if (op == "collinear") {
+    const std::vector<T> &scaled = data.scaled;
+    return {{"raw",
+             [&] {
+               // cross-multiplication against the first nonzero pair
+               size_t pivot = 0;
+               while (pivot < lhs.size() && lhs[pivot] == 0)
+                 pivot++;
+               bool collinear = true;
+               for (size_t i = pivot + 1; i < lhs.size(); i++) {
+                 collinear &= std::fabs(double(lhs[i]) * scaled[pivot] -
+                                        double(scaled[i]) * lhs[pivot]) <= 1e-7;
+               }
+               sink = sink + collinear;
+             },
+             2 * bytes},
+            {"api", [&] { sink = sink + (lhs || scaled); }, 2 * bytes}};
+  }
+  if (op == "reverse") {
+    std::vector<T> &v = data.lhs;
+    return {{"raw",
+             [&] {
+               for (size_t i = 0, j = v.size(); i + 1 < j; i++, j--)
+                 std::swap(v[i], v[j - 1]);
+               sink = sink + v[0];
+             },
+             2 * bytes},
+            {"std",
+             [&] {
+               std::reverse(v.begin(), v.end());
+               sink = sink + v[0];
+             },
+             2 * bytes},
+            {"api",
+             [&] {
+               task::reverse(v);
+               sink = sink + v[0];
+             },
+             2 * bytes}};
+  }
+  const double text = static_cast<double>(data.text.size());
+  if (op == "print") {
+    std::vector<char> &chars = data.chars;
+    return {{"raw",
+             [&] {
+               char *first = chars.data(), *last = first + chars.size();
+               for (const T &value : lhs) {
+                 first = std::to_chars(first, last, value).ptr;
+                 *first++ = ' ';
+               }
+               *first++ = '\n';
+               sink = sink + (first - chars.data());
+             },
+             text},
+            {"to_chars",
+             [&] {
+               std::string res;
+               task::formatTo(res, lhs);
+               sink = sink + res.size();
+             },
+             text},
+            {"std",
+             [&] {
+               std::ostringstream output;
+               std::copy(lhs.begin(), lhs.end(), std::ostream_iterator<T>(output, " "));
+               sink = sink + output.tellp();
+             },
+             text},
+            {"api",
+             [&] {
+               std::ostringstream output;
+               output << lhs;
+               sink = sink + output.tellp();
+             },
+             text}};
+  }
+  if (op == "parse") {
+    const std::string &input = data.text;
+    return {{"raw",
+             [&] {
+               const char *first = input.data(), *last = first + input.size();
+               size_t len = 0;
+               first = std::from_chars(first, last, len).ptr;
+               for (size_t i = 0; i < len; i++) {
+                 while (*first == ' ')
+                   first++;
+                 first = std::from_chars(first, last, out[i]).ptr;
+               }
+               sink = sink + out[0];
+             },
+             text},
+            {"to_chars",
+             [&] {
+               std::vector<T> res;
+               task::parseText(input.data(), input.data() + input.size(), res);
+               sink = sink + res[0];
+             },
+             text},
+            {"api",
+             [&] {
+               std::istringstream stream(input);
+               std::vector<T> res;
+               stream >> res;
+               sink = sink + res[0];
+             },
+             text}};
+  }
+  throw std::invalid_argument("unknown operation " + op);
+}
+
+void writeJson(const std::string &path, const std::vector<Result> &results) {
+  std::ofstream output(path, std::ios::trunc);
+  output << "{\n  \"isa\": \"" << isaName(task::simd::active()) << "\",\n  \"results\": [\n";
+  for (size_t i = 0; i < results.size(); i++) {
+    const Result &res = results[i];
+    output << "    {\"op\": \"" << res.op << "\", \"type\": \"" << res.type
+           << "\", \"variant\": \"" << res.variant << "\", \"size\": " << res.size
+           << ", \"ns_per_element\": " << res.ns_per_element << ", \"best_ns\": " << res.best_ns
+           << ", \"gbps\": " << res.gbps << ", \"noise\": " << res.noise
+           << ", \"reps\": " << res.reps << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+  }
+  output << "  ]\n}\n";
+}
+
+// Reads files written by writeJson(), one result object per line
+std::vector<Result> readJson(const std::string &path) {
+  std::ifstream input(path);
+  if (!input)
+    throw std::runtime_error("cannot open " + path);
+  auto field = [](const std::string &line, const std::string &key) {
+    const size_t pos = line.find("\"" + key + "\": ");
+    return pos == std::string::npos ? std::string() : line.substr(pos + key.size() + 4);
+  };
+  auto text = [&](const std::string &line, const std::string &key) {
+    const std::string value = field(line, key);
+    return value.empty() ? value : value.substr(1, value.find('"', 1) - 1);
+  };
+  std::vector<Result> results;
+  std::string line;
+  while (std::getline(input, line)) {
+    const std::string op = text(line, "op");
+    if (op.empty())
+      continue;
+    Result res;
+    res.op = op;
+    res.type = text(line, "type");
+    res.variant = text(line, "variant");
+    res.size = std::stoul(field(line, "size"));
+    res.ns_per_element = std::stod(field(line, "ns_per_element"));
+    res.best_ns = std::stod(field(line, "best_ns"));
+    res.noise = std::stod(field(line, "noise"));
+    results.push_back(res);
+  }
+  return results;
+}
+
+// Runs are compared by their fastest samples. A result regresses when it is
+// slower by more than the threshold, or by more than twice the noise
+// measured in either run if that is larger
+int compare(const Options &options) {
+  const std::vector<Result> old_results = readJson(options.compare_old);
+  const std::vector<Result> new_results = readJson(options.compare_new);
+  using Key = std::tuple<std::string, std::string, std::string, size_t>;
+  std::map<Key, Result> baseline;
+  for (const Result &res : old_results)
+    baseline[{res.op, res.type, res.variant, res.size}] = res;
+
+  size_t regressions = 0;
+  std::cout << std::left << std::setw(10) << "op" << std::setw(7) << "type" << std::setw(9)
+            << "variant" << std::right << std::setw(10) << "size" << std::setw(14)
+            << "old best ns" << std::setw(14) << "new best ns" << std::setw(10) << "change"
+            << "\n";
+  for (const Result &res : new_results) {
+    auto found = baseline.find({res.op, res.type, res.variant, res.size});
+    if (found == baseline.end())
+      continue;
+    const Result &old = found->second;
+    const double change = res.best_ns / old.best_ns - 1.;
+    const double limit = std::max(options.threshold, 2. * std::max(old.noise, res.noise));
+    const char *verdict = change > limit ? "  REGRESSION" : change < -limit ? "  faster" : "";
+    regressions += change > limit;
+    std::cout << std::left << std::setw(10) << res.op << std::setw(7) << res.type
+              << std::setw(9) << res.variant << std::right << std::setw(10) << res.size
+              << std::fixed << std::setprecision(3) << std::setw(14) << old.best_ns
+              << std::setw(14) << res.best_ns << std::setprecision(1) << std::setw(9)
+              << change * 100. << "%" << verdict << "\n";
+  }
+  std::cout << regressions << " regression(s)\n";
+  return regressions > 0 ? 1 : 0;
+}
+
+std::vector<std::string> split(const std::string &list) {
+  std::vector<std::string> res;
+  std::istringstream input(list);
+  std::string item;
+  while (std::getline(input, item, ','))
+    res.push_back(item);
+  return res;
+}
+
+// Sizes are @min_size and then powers of ten: 3, 10, 100, ...
+size_t nextSize(size_t size) {
+  size_t next = 1;
+  while (next <= size)
+    next *= 10;
+  return next;
+}
+
+template <typename T>
+void runType(const std::string &type, size_t size, const Options &options,
+             std::mt19937_64 &rand, std::vector<Result> &results) {
+  Data<T> data(size, options, rand);
+  for (const std::string &op : options.ops) {
+    // ratio to the raw loop shows the overhead of the other variants
+    double raw_ns = 0;
+    for (const Workload &work : workloads(op, data)) {
+      const Result res = measure(op, type, size, work);
+      results.push_back(res);
+      if (res.variant == "raw")
+        raw_ns = res.ns_per_element;
+      std::cout << std::left << std::setw(10) << res.op << std::setw(7) << res.type
+                << std::setw(9) << res.variant << std::right << std::setw(10) << res.size
+                << std::fixed << std::setprecision(3) << std::setw(12) << res.ns_per_element
+                << std::setprecision(2) << std::setw(10) << res.gbps << std::setw(9);
+      if (raw_ns > 0)
+        std::cout << res.ns_per_element / raw_ns;
+      else
+        std::cout << "-";
+      std::cout << std::setw(7) << res.noise * 100. << "%" << std::endl;
+    }
+  }
+}
+
+void run(const Options &options) {
+  for (const std::string &op : options.ops) {
+    if (std::find(std::begin(known_ops), std::end(known_ops), op) == std::end(known_ops))
+      throw std::invalid_argument("unknown operation " + op);
+  }
+  for (const std::string &type : options.types) {
+    if (std::find(std::begin(known_types), std::end(known_types), type) == std::end(known_types))
+      throw std::invalid_argument("unknown type " + type);
+  }
+  std::mt19937_64 rand(42);
+  std::vector<Result> results;
+  std::cout << "isa: " << isaName(task::simd::active()) << "\n"
+            << std::left << std::setw(10) << "op" << std::setw(7) << "type" << std::setw(9)
+            << "variant" << std::right << std::setw(10) << "size" << std::setw(12) << "ns/elem"
+            << std::setw(10) << "GB/s" << std::setw(9) << "x raw" << std::setw(8) << "noise"
+            << "\n";
+  for (size_t size = std::max<size_t>(3, options.min_size); size <= options.max_size;
+       size = nextSize(size)) {
+    for (const std::string &type : options.types) {
+      if (type == "int")
+        runType<int>(type, size, options, rand, results);
+      else if (type == "float")
+        runType<float>(type, size, options, rand, results);
+      else
+        runType<double>(type, size, options, rand, results);
+    }
+  }
+  writeJson(options.json, results);
+  std::cout << "results written to " << options.json << "\n";
+}
+
+void usage() {
+  std::cout << "usage: vector_ops_bench [--min-size N] [--max-size N] [--ops a,b,...]\n"
+               "                        [--types a,b,...] [--json PATH]\n"
+               "       vector_ops_bench --compare OLD.json NEW.json [--threshold FRACTION]\n"
+               "ops: dot, cross, add, sub, or, and, collinear, reverse, print, parse\n"
+               "types: int, float, double\n"
+               "sizes: --min-size (at least 3), then powers of ten up to --max-size,\n"
+               "e.g. --max-size 100000000 for 1e8 elements\n";
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    const std::string arg = argv[i];
+    const bool has_value = i + 1 < argc;
+    if (arg == "--min-size" && has_value) {
+      options.min_size = std::stoul(argv[++i]);
+    } else if (arg == "--max-size" && has_value) {
+      options.max_size = std::stoul(argv[++i]);
+    } else if (arg == "--ops" && has_value) {
+      options.ops = split(argv[++i]);
+    } else if (arg == "--types" && has_value) {
+      options.types = split(argv[++i]);
+    } else if (arg == "--json" && has_value) {
+      options.json = argv[++i];
+    } else if (arg == "--threshold" && has_value) {
+      options.threshold = std::stod(argv[++i]);
+    } else if (arg == "--compare" && i + 2 < argc) {
+      options.compare_old = argv[++i];
+      options.compare_new = argv[++i];
+    } else {
+      usage();
+      return arg == "--help" ? 0 : 2;
+    }
+  }
+  try {
+    if (!options.compare_old.empty())
+      return compare(options);
+    run(options);
+  } catch (const std::exception &error) {
+    std::cerr << "vector_ops_bench: " << error.what() << "\n";
+    return 2;
+  }
+  return 0;
+}
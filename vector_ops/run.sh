@@ -2,7 +2,7 @@
 
 set -e
 
-g++ -std=c++17 -I./ test/test.cpp -o vector_ops_test
+g++ -std=c++17 -pthread -I./ test/test.cpp -o vector_ops_test
 ./vector_ops_test
 
 echo All tests passed!
\ No newline at end of file
@@ -0,0 +1,400 @@
+#pragma once
+
+#include <algorithm>   //< for std::min
+#include <cassert>     //< for assert
+#include <cstdint>     //< for uint64_t
+#include <type_traits> //< for std::is_integral
+#include <vector>      //< for std::vector
+
+#include "blas.h"
+#include "span.h"
+
+namespace task {
+
+namespace detail {
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+struct OrOp {
+  template <typename V>
+  __attribute__((always_inline)) static void apply(V &a, const V &b) {
+    a |= b;
+  }
+};
+
+struct AndOp {
+  template <typename V>
+  __attribute__((always_inline)) static void apply(V &a, const V &b) {
+    a &= b;
+  }
+};
+
+struct XorOp {
+  template <typename V>
+  __attribute__((always_inline)) static void apply(V &a, const V &b) {
+    a ^= b;
+  }
+};
+
+struct AndNotOp {
+  template <typename V>
+  __attribute__((always_inline)) static void apply(V &a, const V &b) {
+    a &= ~b;
+  }
+};
+
+/**
+ * out[i] = op(a[i], b[i]) over integers, out may alias a or b
+ */
+template <typename Op>
+struct BitwiseKernel {
+  template <typename V, typename T>
+  __attribute__((always_inline)) static void run(size_t n, const T *a, const T *b, T *out) {
+    size_t i = 0;
+    for (; i + lanes<V, T>() <= n; i += lanes<V, T>()) {
+      V x = loadLanes<V>(a + i);
+      Op::apply(x, loadLanes<V>(b + i));
+      storeLanes(out + i, x);
+    }
+    for (; i < n; i++) {
+      T x = a[i];
+      Op::apply(x, b[i]);
+      out[i] = x;
+    }
+  }
+};
+
+/**
+ * Reduction of words with op: OR of all words for any(),
+ * AND of all words for all()
+ */
+template <typename Op>
+struct WordReduceKernel {
+  template <typename V, typename T>
+  __attribute__((always_inline)) static T run(size_t n, const T *a, T identity) {
+    T res = identity;
+    size_t i = 0;
+    if constexpr (lanes<V, T>() > 1) {
+      V acc = V{} + identity;
+      for (; i + lanes<V, T>() <= n; i += lanes<V, T>())
+        Op::apply(acc, loadLanes<V>(a + i));
+      for (size_t k = 0; k < lanes<V, T>(); k++)
+        Op::apply(res, T(acc[k]));
+    }
+    for (; i < n; i++)
+      Op::apply(res, a[i]);
+    return res;
+  }
+};
+
+#pragma GCC diagnostic pop
+
+/**
+ * Set bits count, four accumulators keep several popcnt in flight
+ */
+__attribute__((always_inline)) inline size_t popcountWords(const uint64_t *words, size_t n) {
+  size_t acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    acc0 += __builtin_popcountll(words[i]);
+    acc1 += __builtin_popcountll(words[i + 1]);
+    acc2 += __builtin_popcountll(words[i + 2]);
+    acc3 += __builtin_popcountll(words[i + 3]);
+  }
+  for (; i < n; i++)
+    acc0 += __builtin_popcountll(words[i]);
+  return (acc0 + acc1) + (acc2 + acc3);
+}
+
+#ifdef TASK_SIMD_X86
+__attribute__((target("popcnt"))) inline size_t popcountPopcnt(const uint64_t *words, size_t n) {
+  return popcountWords(words, n);
+}
+#endif
+
+inline size_t popcount(const uint64_t *words, size_t n) {
+#ifdef TASK_SIMD_X86
+  static const bool hardware = simd::active() != simd::Isa::Generic &&
+                               __builtin_cpu_supports("popcnt");
+  if (hardware)
+    return popcountPopcnt(words, n);
+#endif
+  return popcountWords(words, n);
+}
+
+template <typename Op, typename T>
+void bitwise(size_t n, const T *lhs, const T *rhs, T *out) {
+  static_assert(std::is_integral<T>::value, "Integral required.");
+  runKernel<BitwiseKernel<Op>, T>(n, lhs, rhs, out);
+}
+
+template <typename Op, typename T, typename Alloc>
+std::vector<T, Alloc> &bitwise(std::vector<T, Alloc> &out, const std::vector<T, Alloc> &lhs,
+                               const std::vector<T, Alloc> &rhs) {
+  assert(lhs.size() == rhs.size());
+  out.resize(lhs.size());
+  bitwise<Op>(lhs.size(), lhs.data(), rhs.data(), out.data());
+  return out;
+}
+
+template <typename Op, typename T>
+Span<T> bitwise(Span<T> out, Span<const T> lhs, Span<const T> rhs) {
+  assert(lhs.size() == rhs.size() && out.size() == lhs.size());
+  bitwise<Op>(lhs.size(), lhs.data(), rhs.data(), out.data());
+  return out;
+}
+
+} // namespace detail
+
+/**
+ * Vectorized bitwise kernels over integral vectors. The result goes to
+ * @out, resized when needed, @out may be one of the operands.
+ * Span overloads require @out of the operands size
+ */
+
+/**
+ * out[i] = lhs[i] | rhs[i]
+ */
+template <typename T, typename Alloc>
+std::vector<T, Alloc> &bitwise_or(std::vector<T, Alloc> &out, const std::vector<T, Alloc> &lhs,
+                                  const std::vector<T, Alloc> &rhs) {
+  return detail::bitwise<detail::OrOp>(out, lhs, rhs);
+}
+
+template <typename T>
+Span<T> bitwise_or(Span<T> out, Span<const typename Span<T>::value_type> lhs,
+                   Span<const typename Span<T>::value_type> rhs) {
+  return detail::bitwise<detail::OrOp, T>(out, lhs, rhs);
+}
+
+/**
+ * out[i] = lhs[i] & rhs[i]
+ */
+template <typename T, typename Alloc>
+std::vector<T, Alloc> &bitwise_and(std::vector<T, Alloc> &out, const std::vector<T, Alloc> &lhs,
+                                   const std::vector<T, Alloc> &rhs) {
+  return detail::bitwise<detail::AndOp>(out, lhs, rhs);
+}
+
+template <typename T>
+Span<T> bitwise_and(Span<T> out, Span<const typename Span<T>::value_type> lhs,
+                    Span<const typename Span<T>::value_type> rhs) {
+  return detail::bitwise<detail::AndOp, T>(out, lhs, rhs);
+}
+
+/**
+ * out[i] = lhs[i] ^ rhs[i]
+ */
+template <typename T, typename Alloc>
+std::vector<T, Alloc> &bitwise_xor(std::vector<T, Alloc> &out, const std::vector<T, Alloc> &lhs,
+                                   const std::vector<T, Alloc> &rhs) {
+  return detail::bitwise<detail::XorOp>(out, lhs, rhs);
+}
+
+template <typename T>
+Span<T> bitwise_xor(Span<T> out, Span<const typename Span<T>::value_type> lhs,
+                    Span<const typename Span<T>::value_type> rhs) {
+  return detail::bitwise<detail::XorOp, T>(out, lhs, rhs);
+}
+
+/**
+ * out[i] = lhs[i] & ~rhs[i]
+ */
+template <typename T, typename Alloc>
+std::vector<T, Alloc> &bitwise_andnot(std::vector<T, Alloc> &out, const std::vector<T, Alloc> &lhs,
+                                      const std::vector<T, Alloc> &rhs) {
+  return detail::bitwise<detail::AndNotOp>(out, lhs, rhs);
+}
+
+template <typename T>
+Span<T> bitwise_andnot(Span<T> out, Span<const typename Span<T>::value_type> lhs,
+                       Span<const typename Span<T>::value_type> rhs) {
+  return detail::bitwise<detail::AndNotOp, T>(out, lhs, rhs);
+}
+
+/**
+ * Packed vector of bits, 64 elements per word. Bits past size() in the
+ * last word are always zero, so word-wise ops and reductions need no
+ * masking except for the complement
+ */
+class BitVector {
+  std::vector<uint64_t> m_words;
+  size_t m_size = 0;
+
+  static constexpr size_t word_bits = 64;
+
+  static size_t wordCount(size_t n) {
+    return (n + word_bits - 1) / word_bits;
+  }
+
+  // Mask of valid bits in the last word
+  uint64_t tailMask() const {
+    const size_t rest = m_size % word_bits;
+    return rest ? (uint64_t(1) << rest) - 1 : ~uint64_t(0);
+  }
+
+  void clearTail() {
+    if (!m_words.empty())
+      m_words.back() &= tailMask();
+  }
+
+  template <typename Op>
+  BitVector &apply(const BitVector &rhs) {
+    assert(m_size == rhs.m_size);
+    detail::bitwise<Op>(m_words, m_words, rhs.m_words);
+    return *this;
+  }
+
+public:
+  BitVector() = default;
+
+  explicit BitVector(size_t n, bool value = false)
+    : m_words(wordCount(n), value ? ~uint64_t(0) : 0), m_size(n) {
+    clearTail();
+  }
+
+  /**
+   * Pack a mask, bit i is set when @mask[i] is nonzero
+   */
+  template <typename T>
+  explicit BitVector(const std::vector<T> &mask) : m_words(wordCount(mask.size())), m_size(mask.size()) {
+    for (size_t w = 0; w < m_words.size(); w++) {
+      const size_t begin = w * word_bits, end = std::min(m_size, begin + word_bits);
+      uint64_t word = 0;
+      for (size_t i = begin; i < end; i++)
+        word |= uint64_t(mask[i] != T(0)) << (i - begin);
+      m_words[w] = word;
+    }
+  }
+
+  /**
+   * Unpack into a 0/1 mask of bytes
+   */
+  std::vector<char> toMask() const {
+    std::vector<char> mask(m_size);
+    for (size_t i = 0; i < m_size; i++)
+      mask[i] = test(i);
+    return mask;
+  }
+
+  size_t size() const {
+    return m_size;
+  }
+
+  const std::vector<uint64_t> &words() const {
+    return m_words;
+  }
+
+  bool test(size_t i) const {
+    assert(i < m_size);
+    return (m_words[i / word_bits] >> (i % word_bits)) & 1;
+  }
+
+  bool operator[](size_t i) const {
+    return test(i);
+  }
+
+  void set(size_t i, bool value = true) {
+    assert(i < m_size);
+    const uint64_t bit = uint64_t(1) << (i % word_bits);
+    if (value)
+      m_words[i / word_bits] |= bit;
+    else
+      m_words[i / word_bits] &= ~bit;
+  }
+
+  void reset(size_t i) {
+    set(i, false);
+  }
+
+  void push_back(bool value) {
+    if (m_size % word_bits == 0)
+      m_words.push_back(0);
+    m_size++;
+    set(m_size - 1, value);
+  }
+
+  /**
+   * Number of set bits
+   */
+  size_t count() const {
+    return detail::popcount(m_words.data(), m_words.size());
+  }
+
+  bool any() const {
+    return detail::runKernel<detail::WordReduceKernel<detail::OrOp>, uint64_t>(
+               m_words.size(), m_words.data(), uint64_t(0)) != 0;
+  }
+
+  bool none() const {
+    return !any();
+  }
+
+  /**
+   * True when every bit is set, also for empty vector
+   */
+  bool all() const {
+    if (m_words.empty())
+      return true;
+    const uint64_t full = detail::runKernel<detail::WordReduceKernel<detail::AndOp>, uint64_t>(
+        m_words.size() - 1, m_words.data(), ~uint64_t(0));
+    return full == ~uint64_t(0) && m_words.back() == tailMask();
+  }
+
+  BitVector &operator|=(const BitVector &rhs) {
+    return apply<detail::OrOp>(rhs);
+  }
+
+  BitVector &operator&=(const BitVector &rhs) {
+    return apply<detail::AndOp>(rhs);
+  }
+
+  BitVector &operator^=(const BitVector &rhs) {
+    return apply<detail::XorOp>(rhs);
+  }
+
+  /**
+   * this = this & ~rhs
+   */
+  BitVector &andNot(const BitVector &rhs) {
+    return apply<detail::AndNotOp>(rhs);
+  }
+
+  BitVector operator~() const {
+    BitVector res = *this;
+    for (auto &word : res.m_words)
+      word = ~word;
+    res.clearTail();
+    return res;
+  }
+
+  friend bool operator==(const BitVector &lhs, const BitVector &rhs) {
+    return lhs.m_size == rhs.m_size && lhs.m_words == rhs.m_words;
+  }
+
+  friend bool operator!=(const BitVector &lhs, const BitVector &rhs) {
+    return !(lhs == rhs);
+  }
+};
+
+inline BitVector operator|(BitVector lhs, const BitVector &rhs) {
+  return lhs |= rhs;
+}
+
+inline BitVector operator&(BitVector lhs, const BitVector &rhs) {
+  return lhs &= rhs;
+}
+
+inline BitVector operator^(BitVector lhs, const BitVector &rhs) {
+  return lhs ^= rhs;
+}
+
+/**
+ * res = lhs & ~rhs
+ */
+inline BitVector andNot(BitVector lhs, const BitVector &rhs) {
+  return lhs.andNot(rhs);
+}
+
+} // namespace task
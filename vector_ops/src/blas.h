@@ -0,0 +1,322 @@
+#pragma once
+
+#include <cassert>     //< for assert
+#include <cmath>       //< for std::sqrt
+#include <cstring>     //< for std::memcpy
+#include <type_traits> //< for std::is_arithmetic, std::remove_cv_t
+#include <vector>      //< for std::vector
+
+#include "simd.h"
+#include "span.h"
+
+namespace task {
+
+namespace detail {
+
+// Lane values never cross a call boundary, helpers and kernels are always
+// inlined into target specific code, so the AVX ABI warning does not apply
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+/**
+ * Kernels are written once over a lane type V, which is either T itself
+ * (portable path) or a GCC vector of T (16 bytes for SSE2, 32 for AVX2).
+ * Every kernel is instantiated per isa inside a function carrying the
+ * matching target attribute, so the same body is compiled to wide code
+ */
+#ifdef TASK_SIMD_X86
+template <typename T, size_t Bytes>
+struct LanesOf {
+  typedef T type __attribute__((vector_size(Bytes)));
+};
+#endif
+
+template <typename V, typename T>
+constexpr size_t lanes() {
+  return sizeof(V) / sizeof(T);
+}
+
+template <typename V, typename T>
+__attribute__((always_inline)) inline V loadLanes(const T *p) {
+  V v;
+  std::memcpy(&v, p, sizeof(V));
+  return v;
+}
+
+template <typename V, typename T>
+__attribute__((always_inline)) inline void storeLanes(T *p, const V &v) {
+  std::memcpy(p, &v, sizeof(V));
+}
+
+/**
+ * y[i] = alpha * x[i] + beta * y[i]
+ */
+struct AxpbyKernel {
+  template <typename V, typename T>
+  __attribute__((always_inline)) static void run(size_t n, T alpha, const T *x, T beta, T *y) {
+    size_t i = 0;
+    for (; i + lanes<V, T>() <= n; i += lanes<V, T>())
+      storeLanes(y + i, alpha * loadLanes<V>(x + i) + beta * loadLanes<V>(y + i));
+    for (; i < n; i++)
+      y[i] = alpha * x[i] + beta * y[i];
+  }
+};
+
+/**
+ * y[i] += alpha * x[i]
+ */
+struct AxpyKernel {
+  template <typename V, typename T>
+  __attribute__((always_inline)) static void run(size_t n, T alpha, const T *x, T *y) {
+    size_t i = 0;
+    for (; i + lanes<V, T>() <= n; i += lanes<V, T>())
+      storeLanes(y + i, loadLanes<V>(y + i) + alpha * loadLanes<V>(x + i));
+    for (; i < n; i++)
+      y[i] += alpha * x[i];
+  }
+};
+
+/**
+ * x[i] *= alpha
+ */
+struct ScalKernel {
+  template <typename V, typename T>
+  __attribute__((always_inline)) static void run(size_t n, T alpha, T *x) {
+    size_t i = 0;
+    for (; i + lanes<V, T>() <= n; i += lanes<V, T>())
+      storeLanes(x + i, alpha * loadLanes<V>(x + i));
+    for (; i < n; i++)
+      x[i] *= alpha;
+  }
+};
+
+/**
+ * out[i] = a[i] * b[i] + c[i]
+ */
+struct FmaKernel {
+  template <typename V, typename T>
+  __attribute__((always_inline)) static void run(size_t n, const T *a, const T *b,
+                                                 const T *c, T *out) {
+    size_t i = 0;
+    for (; i + lanes<V, T>() <= n; i += lanes<V, T>())
+      storeLanes(out + i, loadLanes<V>(a + i) * loadLanes<V>(b + i) + loadLanes<V>(c + i));
+    for (; i < n; i++)
+      out[i] = a[i] * b[i] + c[i];
+  }
+};
+
+/**
+ * out[i] = a[i] + t * (b[i] - a[i])
+ */
+struct LerpKernel {
+  template <typename V, typename T>
+  __attribute__((always_inline)) static void run(size_t n, const T *a, const T *b, T t, T *out) {
+    size_t i = 0;
+    for (; i + lanes<V, T>() <= n; i += lanes<V, T>()) {
+      const V av = loadLanes<V>(a + i);
+      storeLanes(out + i, av + t * (loadLanes<V>(b + i) - av));
+    }
+    for (; i < n; i++)
+      out[i] = a[i] + t * (b[i] - a[i]);
+  }
+};
+
+/**
+ * Sum of |x[i]|, every lane is widened to DotType<T> before abs,
+ * four accumulators hide add latency
+ */
+struct AsumKernel {
+  template <typename V, typename T>
+  __attribute__((always_inline)) static simd::DotType<T> run(size_t n, const T *x) {
+    using Acc = simd::DotType<T>;
+    constexpr size_t w = lanes<V, T>();
+    Acc res = 0;
+    size_t i = 0;
+    if constexpr (w > 1) {
+#ifdef TASK_SIMD_X86
+      typedef Acc AccV __attribute__((vector_size(w * sizeof(Acc))));
+      AccV acc[4] = {};
+      for (; i + 4 * w <= n; i += 4 * w) {
+        for (size_t k = 0; k < 4; k++) {
+          const AccV v = __builtin_convertvector(loadLanes<V>(x + i + k * w), AccV);
+          acc[k] += v < 0 ? -v : v;
+        }
+      }
+      const AccV sum = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+      for (size_t k = 0; k < w; k++)
+        res += sum[k];
+#endif
+    }
+    for (; i < n; i++)
+      res += x[i] < 0 ? -Acc(x[i]) : Acc(x[i]);
+    return res;
+  }
+};
+
+#ifdef TASK_SIMD_X86
+template <typename Kernel, typename T, typename... Args>
+__attribute__((target("avx2,fma"))) auto runAvx2(Args... args) {
+  return Kernel::template run<typename LanesOf<T, 32>::type, T>(args...);
+}
+
+template <typename Kernel, typename T, typename... Args>
+__attribute__((target("sse2"))) auto runSse2(Args... args) {
+  return Kernel::template run<typename LanesOf<T, 16>::type, T>(args...);
+}
+#endif
+
+template <typename Kernel, typename T, typename... Args>
+auto runKernel(Args... args) {
+  static_assert(std::is_arithmetic<T>::value, "Arithmetic type required.");
+#ifdef TASK_SIMD_X86
+  switch (simd::active()) {
+    case simd::Isa::Avx2:
+      return runAvx2<Kernel, T>(args...);
+    case simd::Isa::Sse2:
+      return runSse2<Kernel, T>(args...);
+    case simd::Isa::Generic:
+      break;
+  }
+#endif
+  return Kernel::template run<T, T>(args...);
+}
+
+#pragma GCC diagnostic pop
+
+} // namespace detail
+
+/**
+ * Level-1 BLAS style kernels over std::vector of float, double or integer
+ * elements. All work in place or into a caller provided destination
+ * (resized when needed, the destination may alias an operand) and run
+ * vectorized for the active simd isa. Span overloads work on memory owned
+ * elsewhere, their destination must already have the operands size
+ */
+
+/**
+ * y = alpha * x + y
+ */
+template <typename T>
+Span<T> axpy(const typename Span<T>::value_type &alpha, Span<const typename Span<T>::value_type> x,
+             Span<T> y) {
+  assert(x.size() == y.size());
+  detail::runKernel<detail::AxpyKernel, T>(x.size(), alpha, x.data(), y.data());
+  return y;
+}
+
+template <typename T, typename Alloc>
+std::vector<T, Alloc> &axpy(const typename std::vector<T, Alloc>::value_type &alpha,
+                            const std::vector<T, Alloc> &x, std::vector<T, Alloc> &y) {
+  axpy(alpha, Span<const T>(x), Span<T>(y));
+  return y;
+}
+
+/**
+ * y = alpha * x + beta * y
+ */
+template <typename T>
+Span<T> axpby(const typename Span<T>::value_type &alpha, Span<const typename Span<T>::value_type> x,
+              const typename Span<T>::value_type &beta, Span<T> y) {
+  assert(x.size() == y.size());
+  detail::runKernel<detail::AxpbyKernel, T>(x.size(), alpha, x.data(), beta, y.data());
+  return y;
+}
+
+template <typename T, typename Alloc>
+std::vector<T, Alloc> &axpby(const typename std::vector<T, Alloc>::value_type &alpha,
+                             const std::vector<T, Alloc> &x,
+                             const typename std::vector<T, Alloc>::value_type &beta,
+                             std::vector<T, Alloc> &y) {
+  axpby(alpha, Span<const T>(x), beta, Span<T>(y));
+  return y;
+}
+
+/**
+ * x = alpha * x
+ */
+template <typename T>
+Span<T> scal(const typename Span<T>::value_type &alpha, Span<T> x) {
+  detail::runKernel<detail::ScalKernel, T>(x.size(), alpha, x.data());
+  return x;
+}
+
+template <typename T, typename Alloc>
+std::vector<T, Alloc> &scal(const typename std::vector<T, Alloc>::value_type &alpha,
+                            std::vector<T, Alloc> &x) {
+  scal(alpha, Span<T>(x));
+  return x;
+}
+
+/**
+ * Element-wise multiply-add, out[i] = a[i] * b[i] + c[i]. Named apart from
+ * ::fma, which a task::fma would hide from unqualified calls in task
+ */
+template <typename T>
+Span<T> fmadd(Span<T> out, Span<const typename Span<T>::value_type> a,
+              Span<const typename Span<T>::value_type> b,
+              Span<const typename Span<T>::value_type> c) {
+  assert(a.size() == b.size() && a.size() == c.size() && out.size() == a.size());
+  detail::runKernel<detail::FmaKernel, T>(a.size(), a.data(), b.data(), c.data(), out.data());
+  return out;
+}
+
+template <typename T, typename Alloc>
+std::vector<T, Alloc> &fmadd(std::vector<T, Alloc> &out, const std::vector<T, Alloc> &a,
+                             const std::vector<T, Alloc> &b, const std::vector<T, Alloc> &c) {
+  out.resize(a.size());
+  fmadd(Span<T>(out), Span<const T>(a), Span<const T>(b), Span<const T>(c));
+  return out;
+}
+
+/**
+ * Linear interpolation into @out, out[i] = a[i] + t * (b[i] - a[i]),
+ * named apart from std::lerp like fmadd
+ */
+template <typename T>
+Span<T> lerp_into(Span<T> out, Span<const typename Span<T>::value_type> a,
+                  Span<const typename Span<T>::value_type> b,
+                  const typename Span<T>::value_type &t) {
+  assert(a.size() == b.size() && out.size() == a.size());
+  detail::runKernel<detail::LerpKernel, T>(a.size(), a.data(), b.data(), t, out.data());
+  return out;
+}
+
+template <typename T, typename Alloc>
+std::vector<T, Alloc> &lerp_into(std::vector<T, Alloc> &out, const std::vector<T, Alloc> &a,
+                                 const std::vector<T, Alloc> &b,
+                                 const typename std::vector<T, Alloc>::value_type &t) {
+  out.resize(a.size());
+  lerp_into(Span<T>(out), Span<const T>(a), Span<const T>(b), t);
+  return out;
+}
+
+/**
+ * Euclidean norm sqrt(sum_i x[i]^2), squares are accumulated as in the
+ * dot product (double for floats, 64-bit for integers) without rescaling,
+ * so results beyond ~1e154 overflow
+ */
+template <typename T>
+double norm2(Span<T> x) {
+  return std::sqrt(static_cast<double>(simd::dot(x.data(), x.data(), x.size())));
+}
+
+template <typename T, typename Alloc>
+double norm2(const std::vector<T, Alloc> &x) {
+  return norm2(Span<const T>(x));
+}
+
+/**
+ * Sum of absolute values, accumulated in simd::DotType<T>
+ */
+template <typename T>
+simd::DotType<std::remove_cv_t<T>> asum(Span<T> x) {
+  using U = std::remove_cv_t<T>;
+  return detail::runKernel<detail::AsumKernel, U>(x.size(), static_cast<const U *>(x.data()));
+}
+
+template <typename T, typename Alloc>
+simd::DotType<T> asum(const std::vector<T, Alloc> &x) {
+  return asum(Span<const T>(x));
+}
+
+} // namespace task
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>   //< for std::min
+#include <cmath>       //< for fabs
+#include <optional>    //< for std::optional
+#include <type_traits> //< for std::is_arithmetic
+
+#include "blas.h"
+
+namespace task {
+
+namespace detail {
+
+// Lane values never cross a call boundary, see blas.h
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+struct CollinearityScan {
+  double lhs_norm = 0;
+  double rhs_norm = 0;
+  bool mismatch = false;
+};
+
+/**
+ * Single division-free pass for collinearity with pivot (lp, rp):
+ * |l[i] * rp - r[i] * lp| <= eps * |r[i] * rp| + slack for every i, which
+ * is |l[i] / r[i] - lp / rp| <= eps without dividing. Zero patterns are
+ * covered too: r[i] == 0 requires l[i] == 0 and vice versa, up to the
+ * absolute @slack given for elements treated as zero.
+ * Squared norms are accumulated on the way, lanes are widened to double
+ */
+struct CollinearityKernel {
+#ifdef TASK_SIMD_X86
+  // Wide part of the pass, stops at the first block with a mismatch
+  template <typename V, typename T>
+  __attribute__((always_inline)) static size_t runLanes(size_t n, const T *l, const T *r,
+                                                        double lp, double rp, double eps,
+                                                        double slack, CollinearityScan &res) {
+    constexpr size_t w = lanes<V, T>();
+    constexpr size_t block = 64;
+    using DV = typename LanesOf<double, w * sizeof(double)>::type;
+    using MV = typename LanesOf<long long, w * sizeof(double)>::type;
+    DV ll = {}, rr = {};
+    MV bad = {};
+    size_t i = 0;
+    while (i + w <= n && !res.mismatch) {
+      for (const size_t end = std::min(n - n % w, i + block); i < end; i += w) {
+        const DV li = __builtin_convertvector(loadLanes<V>(l + i), DV);
+        const DV ri = __builtin_convertvector(loadLanes<V>(r + i), DV);
+        const DV cross = li * rp - ri * lp;
+        const DV bound = ri * (rp * eps);
+        bad |= (cross < 0 ? -cross : cross) > (bound < 0 ? -bound : bound) + slack;
+        ll += li * li;
+        rr += ri * ri;
+      }
+      for (size_t k = 0; k < w; k++)
+        res.mismatch |= bad[k] != 0;
+    }
+    for (size_t k = 0; k < w; k++) {
+      res.lhs_norm += ll[k];
+      res.rhs_norm += rr[k];
+    }
+    return i;
+  }
+#endif
+
+  template <typename V, typename T>
+  __attribute__((always_inline)) static CollinearityScan run(size_t n, const T *l, const T *r,
+                                                             double lp, double rp, double eps,
+                                                             double slack) {
+    CollinearityScan res;
+    size_t i = 0;
+#ifdef TASK_SIMD_X86
+    if constexpr (lanes<V, T>() > 1)
+      i = runLanes<V>(n, l, r, lp, rp, eps, slack, res);
+#endif
+    for (; i < n && !res.mismatch; i++) {
+      const double li = l[i], ri = r[i];
+      res.mismatch = fabs(li * rp - ri * lp) > fabs(ri * rp * eps) + slack;
+      res.lhs_norm += li * li;
+      res.rhs_norm += ri * ri;
+    }
+    return res;
+  }
+};
+
+#pragma GCC diagnostic pop
+
+/**
+ * Whether squared norm of @x is at most @eps, stops as soon as it is not
+ */
+template <typename T>
+bool isZeroVector(const T *x, size_t n, double eps) {
+  double norm = 0;
+  for (size_t i = 0; i < n && norm <= eps; i++)
+    norm += static_cast<double>(x[i]) * static_cast<double>(x[i]);
+  return norm <= eps;
+}
+
+} // namespace detail
+
+/**
+ * Collinearity check helper, find alpha such that @lhs = alpha * @rhs,
+ * otherwise returns empty optional, if vectors are not collinear.
+ * Zero vector is collinear with any other, alpha is 0 then.
+ * Vector with squared norm up to 1e-64 counts as zero, so do elements up
+ * to 1e-64 in absolute value.
+ * One pass, one division: the pivot is the first position where any of
+ * vectors is nonzero, all others are compared by cross-multiplication
+ */
+template <typename T>
+std::optional<double> CollinearityMult(const T *lhs, const T *rhs, size_t n) {
+
+  // squared norms and absolute values below it mean zero
+  static constexpr double nonzero_check_eps = 1.e-64;
+  // required for collinearity check algorithm
+  static constexpr double ratio_diff_check_eps = 1.e-7;
+
+  size_t pivot = 0;
+  while (pivot < n && fabs(static_cast<double>(lhs[pivot])) <= nonzero_check_eps &&
+         fabs(static_cast<double>(rhs[pivot])) <= nonzero_check_eps)
+    pivot++;
+  if (pivot == n)
+    return {0.};
+
+  const double lp = lhs[pivot], rp = rhs[pivot];
+  // elements up to nonzero_check_eps may differ from the exact zero pattern
+  const double slack = nonzero_check_eps * (fabs(lp) + fabs(rp));
+  detail::CollinearityScan scan;
+  if constexpr (std::is_arithmetic<T>::value) {
+    scan = detail::runKernel<detail::CollinearityKernel, T>(
+        n - pivot - 1, lhs + pivot + 1, rhs + pivot + 1, lp, rp, ratio_diff_check_eps, slack);
+  } else {
+    scan = detail::CollinearityKernel::run<T, T>(n - pivot - 1, lhs + pivot + 1, rhs + pivot + 1,
+                                                 lp, rp, ratio_diff_check_eps, slack);
+  }
+  // the scan stops early with partial norms, while a tiny but nonzero
+  // vector still mismatches, so zero vectors are checked in full here
+  if (scan.mismatch) {
+    if (detail::isZeroVector(lhs, n, nonzero_check_eps) ||
+        detail::isZeroVector(rhs, n, nonzero_check_eps))
+      return {0.};
+    return {};
+  }
+  scan.lhs_norm += lp * lp;
+  scan.rhs_norm += rp * rp;
+  // without mismatch rp == 0 is only possible for zero @rhs
+  if (scan.lhs_norm <= nonzero_check_eps || scan.rhs_norm <= nonzero_check_eps)
+    return {0.};
+  return {lp / rp};
+}
+
+} // namespace task
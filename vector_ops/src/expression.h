@@ -0,0 +1,248 @@
+#pragma once
+
+#include <cassert>     //< for assert
+#include <functional>  //< for std::plus, std::minus, std::bit_or, std::bit_and
+#include <memory>      //< for std::allocator
+#include <type_traits> //< for std::enable_if_t, std::is_base_of
+#include <utility>     //< for std::declval
+#include <vector>      //< for std::vector
+
+namespace task {
+
+/**
+ * Lazy element-wise expressions over std::vector.
+ *
+ * lazy(v) wraps a vector into an expression, operators +, -, |, & and
+ * unary +/- on expressions build a tree instead of computing temporaries:
+ *
+ *   std::vector<double> res = lazy(a) + b - c;  // one pass, one allocation
+ *   (lazy(a) + b - c).evalTo(a);                // one pass, no allocation
+ *
+ * The tree is evaluated by a single loop when converted to std::vector,
+ * by eval() or by evalTo(). Vectors are referenced, not copied, so an
+ * expression must not outlive its operands: keep it out of `auto`
+ * variables unless all operands live longer.
+ * Operators on plain vectors (a + b) stay eager.
+ */
+template <typename E>
+class Expression {
+public:
+  const E &self() const {
+    return static_cast<const E &>(*this);
+  }
+
+  size_t size() const {
+    return self().size();
+  }
+
+  /**
+   * Materialize into a new vector
+   */
+  template <typename U = E, typename T = std::decay_t<decltype(std::declval<const U &>()[0])>>
+  std::vector<T> eval() const {
+    std::vector<T> out(size());
+    for (size_t i = 0; i < out.size(); i++)
+      out[i] = self()[i];
+    return out;
+  }
+
+  /**
+   * Materialize into @out reusing its storage, @out may be an operand:
+   * element i only depends on elements i of the operands
+   */
+  template <typename T, typename Alloc>
+  void evalTo(std::vector<T, Alloc> &out) const {
+    out.resize(size());
+    for (size_t i = 0; i < out.size(); i++)
+      out[i] = self()[i];
+  }
+
+  template <typename T, typename Alloc>
+  operator std::vector<T, Alloc>() const {
+    std::vector<T, Alloc> out;
+    evalTo(out);
+    return out;
+  }
+};
+
+/**
+ * Leaf expression referencing a vector
+ */
+template <typename T, typename Alloc = std::allocator<T>>
+class VectorRef : public Expression<VectorRef<T, Alloc>> {
+  const std::vector<T, Alloc> *m_vector;
+
+public:
+  explicit VectorRef(const std::vector<T, Alloc> &v) : m_vector(&v) {}
+
+  size_t size() const {
+    return m_vector->size();
+  }
+
+  const T &operator[](size_t i) const {
+    return (*m_vector)[i];
+  }
+};
+
+/**
+ * res[i] = op(lhs[i], rhs[i])
+ */
+template <typename Op, typename L, typename R>
+class BinaryExpression : public Expression<BinaryExpression<Op, L, R>> {
+  L m_lhs;
+  R m_rhs;
+  Op m_op;
+
+public:
+  BinaryExpression(const L &lhs, const R &rhs, Op op = {})
+    : m_lhs(lhs), m_rhs(rhs), m_op(op) {
+    assert(m_lhs.size() == m_rhs.size());
+  }
+
+  size_t size() const {
+    return m_lhs.size();
+  }
+
+  auto operator[](size_t i) const {
+    return m_op(m_lhs[i], m_rhs[i]);
+  }
+};
+
+/**
+ * res[i] = op(arg[i])
+ */
+template <typename Op, typename E>
+class UnaryExpression : public Expression<UnaryExpression<Op, E>> {
+  E m_arg;
+  Op m_op;
+
+public:
+  explicit UnaryExpression(const E &arg, Op op = {}) : m_arg(arg), m_op(op) {}
+
+  size_t size() const {
+    return m_arg.size();
+  }
+
+  auto operator[](size_t i) const {
+    return m_op(m_arg[i]);
+  }
+};
+
+/**
+ * Wrap @v into a lazy expression, temporaries are rejected
+ */
+template <typename T, typename Alloc>
+VectorRef<T, Alloc> lazy(const std::vector<T, Alloc> &v) {
+  return VectorRef<T, Alloc>(v);
+}
+
+template <typename T, typename Alloc>
+VectorRef<T, Alloc> lazy(const std::vector<T, Alloc> &&v) = delete;
+
+namespace detail {
+
+template <typename E>
+struct IsExpression : std::is_base_of<Expression<E>, E> {};
+
+template <typename E>
+struct IsOperand : IsExpression<E> {};
+
+template <typename T, typename Alloc>
+struct IsOperand<std::vector<T, Alloc>> : std::true_type {};
+
+// Enabled when both are operands and at least one is an expression
+template <typename L, typename R>
+using EnableLazy = std::enable_if_t<IsOperand<L>::value && IsOperand<R>::value &&
+                                    (IsExpression<L>::value || IsExpression<R>::value)>;
+
+template <typename E>
+const E &operand(const Expression<E> &e) {
+  return e.self();
+}
+
+template <typename T, typename Alloc>
+VectorRef<T, Alloc> operand(const std::vector<T, Alloc> &v) {
+  return VectorRef<T, Alloc>(v);
+}
+
+template <typename E>
+using Operand = std::decay_t<decltype(operand(std::declval<const E &>()))>;
+
+template <typename Op, typename L, typename R>
+BinaryExpression<Op, Operand<L>, Operand<R>> makeBinary(const L &lhs, const R &rhs) {
+  return {operand(lhs), operand(rhs)};
+}
+
+struct Negate {
+  template <typename T>
+  auto operator()(const T &a) const {
+    return -a;
+  }
+};
+
+} // namespace detail
+
+/**
+ * Lazy binary plus, res[i] = lhs[i] + rhs[i]
+ */
+template <typename L, typename R, typename = detail::EnableLazy<L, R>>
+auto operator+(const L &lhs, const R &rhs) {
+  return detail::makeBinary<std::plus<>>(lhs, rhs);
+}
+
+/**
+ * Lazy binary minus, res[i] = lhs[i] - rhs[i]
+ */
+template <typename L, typename R, typename = detail::EnableLazy<L, R>>
+auto operator-(const L &lhs, const R &rhs) {
+  return detail::makeBinary<std::minus<>>(lhs, rhs);
+}
+
+/**
+ * Lazy bitwise |, res[i] = lhs[i] | rhs[i]
+ */
+template <typename L, typename R, typename = detail::EnableLazy<L, R>>
+auto operator|(const L &lhs, const R &rhs) {
+  return detail::makeBinary<std::bit_or<>>(lhs, rhs);
+}
+
+/**
+ * Lazy bitwise &, res[i] = lhs[i] & rhs[i]
+ */
+template <typename L, typename R, typename = detail::EnableLazy<L, R>>
+auto operator&(const L &lhs, const R &rhs) {
+  return detail::makeBinary<std::bit_and<>>(lhs, rhs);
+}
+
+/**
+ * Lazy unary plus, expression itself
+ */
+template <typename E>
+E operator+(const Expression<E> &e) {
+  return e.self();
+}
+
+/**
+ * Lazy unary minus, res[i] = -e[i]
+ */
+template <typename E>
+UnaryExpression<detail::Negate, E> operator-(const Expression<E> &e) {
+  return UnaryExpression<detail::Negate, E>(e.self());
+}
+
+/**
+ * Scalar product of expressions, fused with the element-wise chain,
+ * res = sum_i(lhs_i * rhs_i)
+ */
+template <typename L, typename R, typename = detail::EnableLazy<L, R>>
+double operator*(const L &lhs, const R &rhs) {
+  const auto &l = detail::operand(lhs);
+  const auto &r = detail::operand(rhs);
+  assert(l.size() == r.size());
+  double res = 0.0;
+  for (size_t i = 0; i < l.size(); i++)
+    res += static_cast<double>(l[i]) * static_cast<double>(r[i]);
+  return res;
+}
+
+} // namespace task
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <algorithm>   //< for std::min
+#include <cassert>     //< for assert
+#include <charconv>    //< for std::to_chars, std::from_chars
+#include <cstdint>     //< for uint64_t
+#include <cstring>     //< for std::memcpy
+#include <ostream>     //< for std::ostream
+#include <string>      //< for std::string
+#include <type_traits> //< for std::is_arithmetic
+#include <vector>      //< for std::vector
+
+#include "span.h"
+
+namespace task {
+
+/**
+ * Text format is the one of operator<< and operator>>: a vector is written
+ * as its values separated by spaces and ended with a newline, it is read
+ * as a length followed by the values. Values are printed with to_chars,
+ * floating point ones in the shortest form that reads back exactly.
+ *
+ * Binary format of a vector is a uint64_t length in native byte order
+ * followed by the raw values, zero padded to a multiple of 8 bytes, so
+ * in a buffer aligned to 8 every record payload is aligned for T.
+ */
+
+namespace detail {
+
+constexpr size_t binary_align = 8;
+
+inline size_t binaryRecordSize(size_t payload) {
+  return (sizeof(uint64_t) + payload + binary_align - 1) / binary_align * binary_align;
+}
+
+inline const char *skipSpaces(const char *first, const char *last) {
+  while (first != last && (*first == ' ' || *first == '\n' || *first == '\t' || *first == '\r'))
+    first++;
+  return first;
+}
+
+} // namespace detail
+
+/**
+ * Append text form of @v to @out
+ */
+template <typename T>
+std::string &formatTo(std::string &out, const std::vector<T> &v) {
+  static_assert(std::is_arithmetic<T>::value, "Arithmetic type required.");
+  char buf[64];
+  for (const T &value : v) {
+    const auto res = std::to_chars(buf, buf + sizeof(buf) - 1, value);
+    assert(res.ec == std::errc());
+    *res.ptr = ' ';
+    out.append(buf, res.ptr + 1);
+  }
+  out.push_back('\n');
+  return out;
+}
+
+/**
+ * Parse length and values of a vector from [@first, @last) into @v,
+ * leading whitespace is skipped. Returns pointer past the last parsed
+ * value, nullptr on malformed input
+ */
+template <typename T>
+const char *parseText(const char *first, const char *last, std::vector<T> &v) {
+  static_assert(std::is_arithmetic<T>::value, "Arithmetic type required.");
+  size_t len = 0;
+  auto res = std::from_chars(detail::skipSpaces(first, last), last, len);
+  if (res.ec != std::errc())
+    return nullptr;
+  v.resize(len);
+  for (size_t i = 0; i < len; i++) {
+    res = std::from_chars(detail::skipSpaces(res.ptr, last), last, v[i]);
+    if (res.ec != std::errc())
+      return nullptr;
+  }
+  return res.ptr;
+}
+
+/**
+ * Writes text form of vectors into a stream through an internal buffer,
+ * the stream only sees writes of about @capacity bytes. Data is passed
+ * on by flush() and on destruction
+ */
+class TextWriter {
+  std::ostream &m_stream;
+  std::string m_buffer;
+  size_t m_capacity;
+
+public:
+  explicit TextWriter(std::ostream &stream, size_t capacity = size_t(1) << 16)
+    : m_stream(stream), m_capacity(capacity) {
+    m_buffer.reserve(capacity + 1024);
+  }
+
+  TextWriter(const TextWriter &) = delete;
+  TextWriter &operator=(const TextWriter &) = delete;
+
+  ~TextWriter() {
+    flush();
+  }
+
+  template <typename T>
+  TextWriter &operator<<(const std::vector<T> &v) {
+    formatTo(m_buffer, v);
+    if (m_buffer.size() >= m_capacity)
+      flush();
+    return *this;
+  }
+
+  /**
+   * Pass buffered text to the stream, the stream itself is not flushed
+   */
+  void flush() {
+    m_stream.write(m_buffer.data(), m_buffer.size());
+    m_buffer.clear();
+  }
+};
+
+/**
+ * Read-only view of values stored elsewhere, e.g. in a mapped file
+ */
+template <typename T>
+using VectorView = Span<const T>;
+
+/**
+ * Append binary record of @v to @out
+ */
+template <typename T>
+std::string &appendBinary(std::string &out, const std::vector<T> &v) {
+  static_assert(std::is_arithmetic<T>::value, "Arithmetic type required.");
+  const uint64_t len = v.size();
+  const size_t offset = out.size();
+  out.resize(offset + detail::binaryRecordSize(len * sizeof(T)), '\0');
+  std::memcpy(&out[offset], &len, sizeof(len));
+  if (len)
+    std::memcpy(&out[offset + sizeof(len)], v.data(), len * sizeof(T));
+  return out;
+}
+
+/**
+ * Write binary record of @v to stream @s
+ */
+template <typename T>
+std::ostream &writeBinary(std::ostream &s, const std::vector<T> &v) {
+  static_assert(std::is_arithmetic<T>::value, "Arithmetic type required.");
+  static const char padding[detail::binary_align] = {};
+  const uint64_t len = v.size();
+  s.write(reinterpret_cast<const char *>(&len), sizeof(len));
+  s.write(reinterpret_cast<const char *>(v.data()), len * sizeof(T));
+  return s.write(padding, detail::binaryRecordSize(len * sizeof(T)) - sizeof(len) - len * sizeof(T));
+}
+
+/**
+ * View binary record at @first without copying, @first must be aligned
+ * for T. Returns pointer to the next record, nullptr when the record
+ * does not fit into [@first, @last)
+ */
+template <typename T>
+const char *viewBinary(const char *first, const char *last, VectorView<T> &view) {
+  static_assert(std::is_arithmetic<T>::value, "Arithmetic type required.");
+  uint64_t len;
+  if (size_t(last - first) < sizeof(len))
+    return nullptr;
+  std::memcpy(&len, first, sizeof(len));
+  if (len > (size_t(last - first) - sizeof(len)) / sizeof(T))
+    return nullptr;
+  const size_t record = detail::binaryRecordSize(len * sizeof(T));
+  assert(reinterpret_cast<uintptr_t>(first + sizeof(len)) % alignof(T) == 0);
+  view = VectorView<T>(reinterpret_cast<const T *>(first + sizeof(len)), len);
+  return first + std::min<size_t>(record, last - first);
+}
+
+/**
+ * Copy binary record at @first into @v, no alignment requirement.
+ * Returns pointer to the next record, nullptr on truncated input
+ */
+template <typename T>
+const char *readBinary(const char *first, const char *last, std::vector<T> &v) {
+  static_assert(std::is_arithmetic<T>::value, "Arithmetic type required.");
+  uint64_t len;
+  if (size_t(last - first) < sizeof(len))
+    return nullptr;
+  std::memcpy(&len, first, sizeof(len));
+  if (len > (size_t(last - first) - sizeof(len)) / sizeof(T))
+    return nullptr;
+  v.resize(len);
+  if (len)
+    std::memcpy(v.data(), first + sizeof(len), len * sizeof(T));
+  return first + std::min<size_t>(detail::binaryRecordSize(len * sizeof(T)), last - first);
+}
+
+} // namespace task
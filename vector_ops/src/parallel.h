@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>          //< for std::transform, std::min
+#include <atomic>             //< for std::atomic
+#include <cassert>            //< for assert
+#include <condition_variable> //< for std::condition_variable
+#include <functional>         //< for std::function
+#include <mutex>              //< for std::mutex, std::unique_lock
+#include <thread>             //< for std::thread
+#include <vector>             //< for std::vector
+
+#include "simd.h"
+#include "span.h"
+
+namespace task {
+namespace execution {
+
+/**
+ * Parallel policy: work is cut into chunks of a fixed size, chunks are
+ * spread across a shared thread pool. Inputs shorter than @threshold run
+ * on the caller thread, reductions give the same result either way
+ */
+struct ParallelPolicy {
+  // worker count including the caller, 0 means hardware concurrency
+  size_t threads = 0;
+  size_t threshold = size_t(1) << 16;
+};
+
+inline constexpr ParallelPolicy par{};
+
+} // namespace execution
+
+namespace detail {
+
+// Elements per chunk. Fixed, so the reduction tree depends only on size
+constexpr size_t parallel_chunk = size_t(1) << 14;
+
+/**
+ * Process wide pool of worker threads running one job at a time.
+ * A job is @count tasks, func(task) is called once for every task index,
+ * the caller thread takes part. Workers are started on first use and
+ * live until exit. A task may call run() again, the nested job then runs
+ * inline on the thread of that task
+ */
+class ThreadPool {
+  std::vector<std::thread> m_workers;
+  std::mutex m_job_mutex;  //< serializes jobs
+  std::mutex m_mutex;
+  std::condition_variable m_wake;
+  std::condition_variable m_done;
+
+  const std::function<void(size_t)> *m_func = nullptr;
+  size_t m_count = 0;
+  size_t m_participants = 0;
+  size_t m_generation = 0;
+  size_t m_finished = 0;
+  std::atomic<size_t> m_next{0};
+  bool m_stop = false;
+
+  // set while the thread runs tasks of a job, nested jobs go inline
+  static bool &insideJob() {
+    thread_local bool inside = false;
+    return inside;
+  }
+
+  void work() {
+    insideJob() = true;
+    for (size_t task = m_next++; task < m_count; task = m_next++)
+      (*m_func)(task);
+    insideJob() = false;
+  }
+
+  void workerLoop(size_t index) {
+    size_t seen = 0;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+      m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+      if (m_stop)
+        return;
+      seen = m_generation;
+      if (index >= m_participants)
+        continue;
+      lock.unlock();
+      work();
+      lock.lock();
+      if (++m_finished == m_participants)
+        m_done.notify_one();
+    }
+  }
+
+public:
+  ThreadPool() {
+    const size_t count = std::max(1u, std::thread::hardware_concurrency()) - 1;
+    for (size_t i = 0; i < count; i++)
+      m_workers.emplace_back([this, i] { workerLoop(i); });
+  }
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto &worker : m_workers)
+      worker.join();
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  static ThreadPool &instance() {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  /**
+   * Run func(0) ... func(count - 1) on up to @threads threads,
+   * func must not throw
+   */
+  void run(size_t count, size_t threads, const std::function<void(size_t)> &func) {
+    const size_t helpers = std::min({threads > 0 ? threads - 1 : m_workers.size(),
+                                     m_workers.size(), count > 0 ? count - 1 : 0});
+    if (helpers == 0 || insideJob()) {
+      for (size_t task = 0; task < count; task++)
+        func(task);
+      return;
+    }
+    std::lock_guard<std::mutex> job_lock(m_job_mutex);
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_func = &func;
+      m_count = count;
+      m_participants = helpers;
+      m_finished = 0;
+      m_next = 0;
+      m_generation++;
+    }
+    m_wake.notify_all();
+    work();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [&] { return m_finished == m_participants; });
+  }
+};
+
+inline size_t chunkCount(size_t n) {
+  return (n + parallel_chunk - 1) / parallel_chunk;
+}
+
+/**
+ * Call func(begin, end) for every chunk, in parallel for large @n
+ */
+template <typename Func>
+void parallelChunks(const execution::ParallelPolicy &policy, size_t n, Func func) {
+  const size_t chunks = chunkCount(n);
+  const std::function<void(size_t)> task = [&](size_t chunk) {
+    func(chunk * parallel_chunk, std::min(n, (chunk + 1) * parallel_chunk));
+  };
+  ThreadPool::instance().run(chunks, n < policy.threshold ? 1 : policy.threads, task);
+}
+
+/**
+ * Deterministic reduction: partial = func(begin, end) per chunk, partials
+ * are combined pairwise in a fixed tree, independent of thread count
+ */
+template <typename R, typename Func, typename Combine>
+R parallelReduce(const execution::ParallelPolicy &policy, size_t n, R identity, Func func,
+                 Combine combine) {
+  const size_t chunks = chunkCount(n);
+  if (chunks == 0)
+    return identity;
+  std::vector<R> partial(chunks, identity);
+  parallelChunks(policy, n, [&](size_t begin, size_t end) {
+    partial[begin / parallel_chunk] = func(begin, end);
+  });
+  for (size_t step = 1; step < chunks; step *= 2) {
+    for (size_t i = 0; i + step < chunks; i += 2 * step)
+      partial[i] = combine(partial[i], partial[i + step]);
+  }
+  return partial[0];
+}
+
+} // namespace detail
+
+/**
+ * Parallel transform wrapper, res[i] = func(lhs[i], rhs[i])
+ */
+template <typename T, typename Alloc, typename Functor>
+std::vector<T, Alloc> VectorTransform(const execution::ParallelPolicy &policy,
+                                      const std::vector<T, Alloc> &lhs,
+                                      const std::vector<T, Alloc> &rhs, Functor func) {
+  assert(lhs.size() == rhs.size());
+  std::vector<T, Alloc> out(lhs.size(), lhs.get_allocator());
+  detail::parallelChunks(policy, lhs.size(), [&](size_t begin, size_t end) {
+    std::transform(lhs.begin() + begin, lhs.begin() + end, rhs.begin() + begin,
+                   out.begin() + begin, func);
+  });
+  return out;
+}
+
+/**
+ * Parallel transform_into, out[i] = func(lhs[i], rhs[i]) into @out of the
+ * operands size, @out may view one of the operands
+ */
+template <typename T, typename U, typename V, typename Functor>
+Span<T> transform_into(const execution::ParallelPolicy &policy, Span<T> out, Span<U> lhs,
+                       Span<V> rhs, Functor func) {
+  assert(lhs.size() == rhs.size() && out.size() == lhs.size());
+  detail::parallelChunks(policy, lhs.size(), [&](size_t begin, size_t end) {
+    std::transform(lhs.begin() + begin, lhs.begin() + end, rhs.begin() + begin,
+                   out.begin() + begin, func);
+  });
+  return out;
+}
+
+/**
+ * Parallel transform_into, out[i] = func(lhs[i], rhs[i]),
+ * @out may be one of the operands
+ */
+template <typename T, typename A, typename U, typename B, typename V, typename C,
+          typename Functor>
+std::vector<T, A> &transform_into(const execution::ParallelPolicy &policy, std::vector<T, A> &out,
+                                  const std::vector<U, B> &lhs, const std::vector<V, C> &rhs,
+                                  Functor func) {
+  assert(lhs.size() == rhs.size());
+  out.resize(lhs.size());
+  transform_into(policy, Span<T>(out), Span<const U>(lhs), Span<const V>(rhs), func);
+  return out;
+}
+
+/**
+ * Parallel scalar product accumulated in simd::DotType<T>. The result
+ * only depends on the input, not on thread count or threshold
+ */
+template <typename L, typename R, typename T = detail::SpanValue<L, R>>
+simd::DotType<T> dot(const execution::ParallelPolicy &policy, Span<L> lhs, Span<R> rhs) {
+  assert(lhs.size() == rhs.size());
+  using Acc = simd::DotType<T>;
+  return detail::parallelReduce(
+      policy, lhs.size(), Acc(0),
+      [&](size_t begin, size_t end) {
+        return simd::dot<T>(lhs.data() + begin, rhs.data() + begin, end - begin);
+      },
+      [](Acc a, Acc b) { return a + b; });
+}
+
+template <typename T, typename Alloc>
+simd::DotType<T> dot(const execution::ParallelPolicy &policy, const std::vector<T, Alloc> &lhs,
+                     const std::vector<T, Alloc> &rhs) {
+  return dot(policy, Span<const T>(lhs), Span<const T>(rhs));
+}
+
+} // namespace task
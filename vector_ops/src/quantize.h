@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>   //< for std::min, std::max
+#include <cassert>     //< for assert
+#include <cmath>       //< for std::nearbyint
+#include <cstdint>     //< for int8_t, int16_t, int32_t, int64_t
+#include <limits>      //< for std::numeric_limits
+#include <type_traits> //< for std::is_same, std::is_floating_point, std::remove_cv_t
+#include <vector>      //< for std::vector
+
+#include "blas.h"
+#include "reductions.h"
+#include "simd.h"
+#include "span.h"
+
+namespace task {
+
+/**
+ * Vector stored as integer codes with a per-vector affine map,
+ * value[i] ~ scale * (codes[i] - zero_point). Sum of the codes is kept
+ * for the zero point terms of scalar products
+ */
+template <typename Q>
+struct Quantized {
+  static_assert(std::is_same<Q, int8_t>::value || std::is_same<Q, int16_t>::value,
+                "int8_t or int16_t codes required.");
+
+  std::vector<Q> codes;
+  double scale = 1;
+  int32_t zero_point = 0;
+  int64_t code_sum = 0;
+
+  size_t size() const {
+    return codes.size();
+  }
+};
+
+/**
+ * Quantize @v to the full range of Q. The range of values is extended to
+ * contain zero, so zeros are represented exactly; rounding error is at
+ * most scale / 2 per element
+ */
+template <typename Q, typename T>
+Quantized<Q> quantize(Span<T> v) {
+  using U = std::remove_cv_t<T>;
+  static_assert(std::is_floating_point<U>::value, "Floating point required.");
+  constexpr int32_t qmin = std::numeric_limits<Q>::min(), qmax = std::numeric_limits<Q>::max();
+
+  Quantized<Q> res;
+  res.codes.resize(v.size());
+  if (v.empty())
+    return res;
+
+  U lo, hi;
+  detail::runKernel<detail::MinMaxKernel, U>(v.size(), static_cast<const U *>(v.data()), &lo, &hi);
+  const double min = std::min<double>(lo, 0), max = std::max<double>(hi, 0);
+  if (max > min)
+    res.scale = (max - min) / (qmax - qmin);
+  const double zero_point = std::nearbyint(qmin - min / res.scale);
+  res.zero_point = int32_t(std::min<double>(qmax, std::max<double>(qmin, zero_point)));
+
+  const double inv = 1 / res.scale;
+  int64_t code_sum = 0;
+  for (size_t i = 0; i < v.size(); i++) {
+    const double code = std::nearbyint(v[i] * inv) + res.zero_point;
+    res.codes[i] = Q(std::min<double>(qmax, std::max<double>(qmin, code)));
+    code_sum += res.codes[i];
+  }
+  res.code_sum = code_sum;
+  return res;
+}
+
+template <typename Q, typename T, typename Alloc>
+Quantized<Q> quantize(const std::vector<T, Alloc> &v) {
+  return quantize<Q>(Span<const T>(v));
+}
+
+/**
+ * Values approximated by @q, written to @out of q.size()
+ */
+template <typename T, typename Q>
+Span<T> dequantize(Span<T> out, const Quantized<Q> &q) {
+  assert(out.size() == q.size());
+  for (size_t i = 0; i < q.size(); i++)
+    out[i] = T(q.scale * (int32_t(q.codes[i]) - q.zero_point));
+  return out;
+}
+
+template <typename T, typename Alloc, typename Q>
+std::vector<T, Alloc> &dequantize(std::vector<T, Alloc> &out, const Quantized<Q> &q) {
+  out.resize(q.size());
+  dequantize(Span<T>(out), q);
+  return out;
+}
+
+/**
+ * Approximate scalar product of the original vectors. Codes are
+ * multiplied by the int8 / int16 simd kernels, zero points are applied
+ * afterwards through the code sums:
+ * sum (a - za)(b - zb) = sum ab - zb sum a - za sum b + n za zb
+ */
+template <typename Q>
+double dot(const Quantized<Q> &lhs, const Quantized<Q> &rhs) {
+  assert(lhs.size() == rhs.size());
+  const int64_t n = int64_t(lhs.size()), za = lhs.zero_point, zb = rhs.zero_point;
+  const int64_t codes = simd::dot(lhs.codes.data(), rhs.codes.data(), lhs.size());
+  const int64_t res = codes - zb * lhs.code_sum - za * rhs.code_sum + n * za * zb;
+  return lhs.scale * rhs.scale * double(res);
+}
+
+template <typename Q>
+double operator*(const Quantized<Q> &lhs, const Quantized<Q> &rhs) {
+  return dot(lhs, rhs);
+}
+
+} // namespace task
@@ -0,0 +1,386 @@
+#pragma once
+
+#include <algorithm>   //< for std::find, std::max, std::min
+#include <cassert>     //< for assert
+#include <type_traits> //< for std::is_floating_point, std::remove_cv_t
+#include <vector>      //< for std::vector
+
+#include "blas.h"
+#include "simd.h"
+#include "span.h"
+
+namespace task {
+
+/**
+ * Count, mean and sum of squared deviations of a sequence, from which
+ * population and sample variance follow
+ */
+struct Moments {
+  size_t count = 0;
+  double mean = 0;
+  double m2 = 0;
+
+  double variance() const {
+    return count ? m2 / count : 0.;
+  }
+
+  double sampleVariance() const {
+    return count > 1 ? m2 / (count - 1) : 0.;
+  }
+
+  /**
+   * Moments of the concatenation of both sequences (Chan et al.)
+   */
+  Moments &merge(const Moments &other) {
+    if (!other.count)
+      return *this;
+    const double n = double(count) + double(other.count);
+    const double delta = other.mean - mean;
+    mean += delta * (double(other.count) / n);
+    m2 += other.m2 + delta * delta * (double(count) * double(other.count) / n);
+    count += other.count;
+    return *this;
+  }
+};
+
+namespace detail {
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+/**
+ * s + c += v with Neumaier compensation for floating point accumulators,
+ * c collects the rounding error of every addition. Plain sum for integers
+ */
+template <typename Acc, typename D>
+__attribute__((always_inline)) inline void compensatedAdd(D &s, D &c, const D &v) {
+  if constexpr (std::is_floating_point<Acc>::value) {
+    const D t = s + v;
+    const D as = s < 0 ? -s : s, av = v < 0 ? -v : v;
+    c += as >= av ? (s - t) + v : (v - t) + s;
+    s = t;
+  } else {
+    s += v;
+  }
+}
+
+/**
+ * Sum in DotType<T>, compensated for floating point types. Every lane
+ * keeps its own sum and compensation, lanes are folded at the end
+ */
+struct SumKernel {
+#ifdef TASK_SIMD_X86
+  template <typename V, typename T>
+  __attribute__((always_inline)) static size_t runLanes(size_t n, const T *x,
+                                                        simd::DotType<T> &s,
+                                                        simd::DotType<T> &c) {
+    using Acc = simd::DotType<T>;
+    constexpr size_t w = lanes<V, T>();
+    using AccV = typename LanesOf<Acc, w * sizeof(Acc)>::type;
+    AccV vs = {}, vc = {};
+    size_t i = 0;
+    for (; i + w <= n; i += w)
+      compensatedAdd<Acc>(vs, vc, __builtin_convertvector(loadLanes<V>(x + i), AccV));
+    for (size_t k = 0; k < w; k++) {
+      const Acc lane = vs[k];
+      compensatedAdd<Acc>(s, c, lane);
+      c += vc[k];
+    }
+    return i;
+  }
+#endif
+
+  template <typename V, typename T>
+  __attribute__((always_inline)) static simd::DotType<T> run(size_t n, const T *x) {
+    using Acc = simd::DotType<T>;
+    Acc s = 0, c = 0;
+    size_t i = 0;
+#ifdef TASK_SIMD_X86
+    if constexpr (lanes<V, T>() > 1)
+      i = runLanes<V>(n, x, s, c);
+#endif
+    for (; i < n; i++) {
+      const Acc value = x[i];
+      compensatedAdd<Acc>(s, c, value);
+    }
+    return s + c;
+  }
+};
+
+/**
+ * Smallest and largest value of a nonempty range
+ */
+struct MinMaxKernel {
+  template <typename V, typename T>
+  __attribute__((always_inline)) static void run(size_t n, const T *x, T *lo, T *hi) {
+    *lo = *hi = x[0];
+    size_t i = 0;
+    if constexpr (lanes<V, T>() > 1) {
+      if (n >= lanes<V, T>()) {
+        V vlo = loadLanes<V>(x), vhi = vlo;
+        for (i = lanes<V, T>(); i + lanes<V, T>() <= n; i += lanes<V, T>()) {
+          const V v = loadLanes<V>(x + i);
+          vlo = v < vlo ? v : vlo;
+          vhi = v > vhi ? v : vhi;
+        }
+        for (size_t k = 0; k < lanes<V, T>(); k++) {
+          *lo = std::min<T>(*lo, vlo[k]);
+          *hi = std::max<T>(*hi, vhi[k]);
+        }
+      }
+    }
+    for (; i < n; i++) {
+      *lo = std::min(*lo, x[i]);
+      *hi = std::max(*hi, x[i]);
+    }
+  }
+};
+
+/**
+ * One pass mean and variance: Welford update per lane in double,
+ * all lanes see the same count, lanes are merged at the end
+ */
+struct MomentsKernel {
+#ifdef TASK_SIMD_X86
+  template <typename V, typename T>
+  __attribute__((always_inline)) static size_t runLanes(size_t n, const T *x, Moments &res) {
+    constexpr size_t w = lanes<V, T>();
+    using DV = typename LanesOf<double, w * sizeof(double)>::type;
+    DV mean = {}, m2 = {};
+    size_t i = 0, count = 0;
+    for (; i + w <= n; i += w) {
+      const DV v = __builtin_convertvector(loadLanes<V>(x + i), DV);
+      const DV delta = v - mean;
+      mean += delta * (1. / double(++count));
+      m2 += delta * (v - mean);
+    }
+    for (size_t k = 0; k < w && count; k++)
+      res.merge(Moments{count, mean[k], m2[k]});
+    return i;
+  }
+#endif
+
+  template <typename V, typename T>
+  __attribute__((always_inline)) static Moments run(size_t n, const T *x) {
+    Moments res;
+    size_t i = 0;
+#ifdef TASK_SIMD_X86
+    if constexpr (lanes<V, T>() > 1)
+      i = runLanes<V>(n, x, res);
+#endif
+    Moments tail;
+    for (; i < n; i++) {
+      const double v = x[i];
+      const double delta = v - tail.mean;
+      tail.mean += delta / double(++tail.count);
+      tail.m2 += delta * (v - tail.mean);
+    }
+    return res.merge(tail);
+  }
+};
+
+/**
+ * sum[j] + comp[j] += row[j], compensated like SumKernel
+ */
+struct ColumnAddKernel {
+#ifdef TASK_SIMD_X86
+  template <typename V, typename T>
+  __attribute__((always_inline)) static size_t runLanes(size_t n, const T *row,
+                                                        simd::DotType<T> *sum,
+                                                        simd::DotType<T> *comp) {
+    using Acc = simd::DotType<T>;
+    constexpr size_t w = lanes<V, T>();
+    using AccV = typename LanesOf<Acc, w * sizeof(Acc)>::type;
+    size_t i = 0;
+    for (; i + w <= n; i += w) {
+      AccV s = loadLanes<AccV>(sum + i), c = loadLanes<AccV>(comp + i);
+      compensatedAdd<Acc>(s, c, __builtin_convertvector(loadLanes<V>(row + i), AccV));
+      storeLanes(sum + i, s);
+      storeLanes(comp + i, c);
+    }
+    return i;
+  }
+#endif
+
+  template <typename V, typename T>
+  __attribute__((always_inline)) static void run(size_t n, const T *row, simd::DotType<T> *sum,
+                                                 simd::DotType<T> *comp) {
+    using Acc = simd::DotType<T>;
+    size_t i = 0;
+#ifdef TASK_SIMD_X86
+    if constexpr (lanes<V, T>() > 1)
+      i = runLanes<V>(n, row, sum, comp);
+#endif
+    for (; i < n; i++) {
+      const Acc value = row[i];
+      compensatedAdd<Acc>(sum[i], comp[i], value);
+    }
+  }
+};
+
+#pragma GCC diagnostic pop
+
+// Columns per block of columnSums, sums and compensations stay in L1
+constexpr size_t column_block = 256;
+
+} // namespace detail
+
+/**
+ * Vectorized reductions over arithmetic elements. Floating point sums are
+ * accumulated in double with Neumaier compensation, so the error does not
+ * grow with length; integers are summed exactly in 64 bits. Each takes a
+ * Span or a std::vector. NaN elements are not supported by min / max
+ */
+
+/**
+ * Sum of elements in simd::DotType<T>
+ */
+template <typename T>
+simd::DotType<std::remove_cv_t<T>> sum(Span<T> x) {
+  using U = std::remove_cv_t<T>;
+  return detail::runKernel<detail::SumKernel, U>(x.size(), static_cast<const U *>(x.data()));
+}
+
+template <typename T, typename Alloc>
+simd::DotType<T> sum(const std::vector<T, Alloc> &x) {
+  return sum(Span<const T>(x));
+}
+
+/**
+ * Smallest element, @x must not be empty
+ */
+template <typename T>
+std::remove_cv_t<T> minimum(Span<T> x) {
+  using U = std::remove_cv_t<T>;
+  assert(!x.empty());
+  U lo, hi;
+  detail::runKernel<detail::MinMaxKernel, U>(x.size(), static_cast<const U *>(x.data()), &lo, &hi);
+  return lo;
+}
+
+template <typename T, typename Alloc>
+T minimum(const std::vector<T, Alloc> &x) {
+  return minimum(Span<const T>(x));
+}
+
+/**
+ * Largest element, @x must not be empty
+ */
+template <typename T>
+std::remove_cv_t<T> maximum(Span<T> x) {
+  using U = std::remove_cv_t<T>;
+  assert(!x.empty());
+  U lo, hi;
+  detail::runKernel<detail::MinMaxKernel, U>(x.size(), static_cast<const U *>(x.data()), &lo, &hi);
+  return hi;
+}
+
+template <typename T, typename Alloc>
+T maximum(const std::vector<T, Alloc> &x) {
+  return maximum(Span<const T>(x));
+}
+
+/**
+ * Index of the first smallest element, @x must not be empty
+ */
+template <typename T>
+size_t argmin(Span<T> x) {
+  return std::find(x.begin(), x.end(), minimum(x)) - x.begin();
+}
+
+template <typename T, typename Alloc>
+size_t argmin(const std::vector<T, Alloc> &x) {
+  return argmin(Span<const T>(x));
+}
+
+/**
+ * Index of the first largest element, @x must not be empty
+ */
+template <typename T>
+size_t argmax(Span<T> x) {
+  return std::find(x.begin(), x.end(), maximum(x)) - x.begin();
+}
+
+template <typename T, typename Alloc>
+size_t argmax(const std::vector<T, Alloc> &x) {
+  return argmax(Span<const T>(x));
+}
+
+/**
+ * L1 norm, sum of absolute values
+ */
+template <typename T>
+double norm1(Span<T> x) {
+  return static_cast<double>(asum(x));
+}
+
+template <typename T, typename Alloc>
+double norm1(const std::vector<T, Alloc> &x) {
+  return norm1(Span<const T>(x));
+}
+
+/**
+ * Maximum norm, largest absolute value, 0 for empty @x
+ */
+template <typename T>
+double normInf(Span<T> x) {
+  if (x.empty())
+    return 0.;
+  using U = std::remove_cv_t<T>;
+  U lo, hi;
+  detail::runKernel<detail::MinMaxKernel, U>(x.size(), static_cast<const U *>(x.data()), &lo, &hi);
+  return std::max(-static_cast<double>(lo), static_cast<double>(hi));
+}
+
+template <typename T, typename Alloc>
+double normInf(const std::vector<T, Alloc> &x) {
+  return normInf(Span<const T>(x));
+}
+
+/**
+ * Count, mean and variance in a single pass
+ */
+template <typename T>
+Moments moments(Span<T> x) {
+  using U = std::remove_cv_t<T>;
+  return detail::runKernel<detail::MomentsKernel, U>(x.size(), static_cast<const U *>(x.data()));
+}
+
+template <typename T, typename Alloc>
+Moments moments(const std::vector<T, Alloc> &x) {
+  return moments(Span<const T>(x));
+}
+
+/**
+ * Column sums of a row-major matrix with @cols columns stored in @data,
+ * compensated like sum(). Columns are processed in blocks so that
+ * running sums stay in cache while all rows stream through once per block
+ */
+template <typename T>
+std::vector<simd::DotType<std::remove_cv_t<T>>> &columnSums(
+    std::vector<simd::DotType<std::remove_cv_t<T>>> &out, Span<T> data, size_t cols) {
+  using U = std::remove_cv_t<T>;
+  using Acc = simd::DotType<U>;
+  assert(cols > 0 && data.size() % cols == 0);
+  const size_t rows = data.size() / cols;
+  out.assign(cols, Acc(0));
+  Acc comp[detail::column_block];
+  for (size_t begin = 0; begin < cols; begin += detail::column_block) {
+    const size_t width = std::min(detail::column_block, cols - begin);
+    std::fill(comp, comp + width, Acc(0));
+    for (size_t r = 0; r < rows; r++)
+      detail::runKernel<detail::ColumnAddKernel, U>(
+          width, static_cast<const U *>(data.data() + r * cols + begin), out.data() + begin, comp);
+    for (size_t j = 0; j < width; j++)
+      out[begin + j] += comp[j];
+  }
+  return out;
+}
+
+template <typename T, typename Alloc>
+std::vector<simd::DotType<T>> &columnSums(std::vector<simd::DotType<T>> &out,
+                                          const std::vector<T, Alloc> &data, size_t cols) {
+  return columnSums(out, Span<const T>(data), cols);
+}
+
+} // namespace task
@@ -0,0 +1,389 @@
+#pragma once
+
+#include <cstddef>     //< for size_t
+#include <cstdint>     //< for int8_t, int16_t, int64_t, uint64_t
+#include <cstdlib>     //< for std::getenv
+#include <cstring>     //< for std::strcmp
+#include <type_traits> //< for std::conditional_t
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define TASK_SIMD_X86 1
+#endif
+
+namespace task {
+namespace simd {
+
+/**
+ * Instruction sets with dedicated kernels, ordered from weakest
+ */
+enum class Isa { Generic, Sse2, Avx2 };
+
+/**
+ * Accumulator type of dot product over T: floats are widened to double,
+ * integers to 64 bits of the same signedness
+ */
+template <typename T>
+using DotType = std::conditional_t<
+    std::is_floating_point<T>::value,
+    std::conditional_t<(sizeof(T) > sizeof(double)), T, double>,
+    std::conditional_t<std::is_signed<T>::value, int64_t, uint64_t>>;
+
+namespace detail {
+
+/**
+ * Portable dot product, four independent accumulators hide FP add latency
+ */
+template <typename T>
+DotType<T> dotGeneric(const T *lhs, const T *rhs, size_t n) {
+  using Acc = DotType<T>;
+  Acc acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    acc0 += Acc(lhs[i]) * Acc(rhs[i]);
+    acc1 += Acc(lhs[i + 1]) * Acc(rhs[i + 1]);
+    acc2 += Acc(lhs[i + 2]) * Acc(rhs[i + 2]);
+    acc3 += Acc(lhs[i + 3]) * Acc(rhs[i + 3]);
+  }
+  for (; i < n; i++)
+    acc0 += Acc(lhs[i]) * Acc(rhs[i]);
+  return (acc0 + acc1) + (acc2 + acc3);
+}
+
+#ifdef TASK_SIMD_X86
+
+/////////////////////////// SSE2 kernels, 2 double lanes
+
+__attribute__((target("sse2")))
+inline double hsum(__m128d v) {
+  return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+__attribute__((target("sse2")))
+inline double dotSse2(const double *lhs, const double *rhs, size_t n) {
+  __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+  __m128d acc2 = _mm_setzero_pd(), acc3 = _mm_setzero_pd();
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_loadu_pd(lhs + i), _mm_loadu_pd(rhs + i)));
+    acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(lhs + i + 2), _mm_loadu_pd(rhs + i + 2)));
+    acc2 = _mm_add_pd(acc2, _mm_mul_pd(_mm_loadu_pd(lhs + i + 4), _mm_loadu_pd(rhs + i + 4)));
+    acc3 = _mm_add_pd(acc3, _mm_mul_pd(_mm_loadu_pd(lhs + i + 6), _mm_loadu_pd(rhs + i + 6)));
+  }
+  double res = hsum(_mm_add_pd(_mm_add_pd(acc0, acc1), _mm_add_pd(acc2, acc3)));
+  for (; i < n; i++)
+    res += lhs[i] * rhs[i];
+  return res;
+}
+
+__attribute__((target("sse2")))
+inline double dotSse2(const float *lhs, const float *rhs, size_t n) {
+  __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+  __m128d acc2 = _mm_setzero_pd(), acc3 = _mm_setzero_pd();
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m128 l0 = _mm_loadu_ps(lhs + i), r0 = _mm_loadu_ps(rhs + i);
+    const __m128 l1 = _mm_loadu_ps(lhs + i + 4), r1 = _mm_loadu_ps(rhs + i + 4);
+    acc0 = _mm_add_pd(acc0, _mm_mul_pd(_mm_cvtps_pd(l0), _mm_cvtps_pd(r0)));
+    acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(l0, l0)),
+                                       _mm_cvtps_pd(_mm_movehl_ps(r0, r0))));
+    acc2 = _mm_add_pd(acc2, _mm_mul_pd(_mm_cvtps_pd(l1), _mm_cvtps_pd(r1)));
+    acc3 = _mm_add_pd(acc3, _mm_mul_pd(_mm_cvtps_pd(_mm_movehl_ps(l1, l1)),
+                                       _mm_cvtps_pd(_mm_movehl_ps(r1, r1))));
+  }
+  double res = hsum(_mm_add_pd(_mm_add_pd(acc0, acc1), _mm_add_pd(acc2, acc3)));
+  for (; i < n; i++)
+    res += double(lhs[i]) * double(rhs[i]);
+  return res;
+}
+
+/////////////////////////// AVX2 + FMA kernels, 4 double lanes
+
+__attribute__((target("avx2,fma")))
+inline double hsum(__m256d v) {
+  const __m128d sum = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+}
+
+__attribute__((target("avx2,fma")))
+inline double dotAvx2(const double *lhs, const double *rhs, size_t n) {
+  __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+  __m256d acc2 = _mm256_setzero_pd(), acc3 = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(lhs + i), _mm256_loadu_pd(rhs + i), acc0);
+    acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(lhs + i + 4), _mm256_loadu_pd(rhs + i + 4), acc1);
+    acc2 = _mm256_fmadd_pd(_mm256_loadu_pd(lhs + i + 8), _mm256_loadu_pd(rhs + i + 8), acc2);
+    acc3 = _mm256_fmadd_pd(_mm256_loadu_pd(lhs + i + 12), _mm256_loadu_pd(rhs + i + 12), acc3);
+  }
+  for (; i + 4 <= n; i += 4)
+    acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(lhs + i), _mm256_loadu_pd(rhs + i), acc0);
+  double res = hsum(_mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3)));
+  for (; i < n; i++)
+    res += lhs[i] * rhs[i];
+  return res;
+}
+
+__attribute__((target("avx2,fma")))
+inline double dotAvx2(const float *lhs, const float *rhs, size_t n) {
+  __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+  __m256d acc2 = _mm256_setzero_pd(), acc3 = _mm256_setzero_pd();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m256 l0 = _mm256_loadu_ps(lhs + i), r0 = _mm256_loadu_ps(rhs + i);
+    const __m256 l1 = _mm256_loadu_ps(lhs + i + 8), r1 = _mm256_loadu_ps(rhs + i + 8);
+    acc0 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(l0)),
+                           _mm256_cvtps_pd(_mm256_castps256_ps128(r0)), acc0);
+    acc1 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(l0, 1)),
+                           _mm256_cvtps_pd(_mm256_extractf128_ps(r0, 1)), acc1);
+    acc2 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(l1)),
+                           _mm256_cvtps_pd(_mm256_castps256_ps128(r1)), acc2);
+    acc3 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(l1, 1)),
+                           _mm256_cvtps_pd(_mm256_extractf128_ps(r1, 1)), acc3);
+  }
+  double res = hsum(_mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3)));
+  for (; i < n; i++)
+    res += double(lhs[i]) * double(rhs[i]);
+  return res;
+}
+
+// 4 int32 sign extended to int64 lanes
+__attribute__((target("avx2,fma")))
+inline __m256i loadWiden(const int32_t *p) {
+  return _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)));
+}
+
+__attribute__((target("avx2,fma")))
+inline int64_t dotAvx2(const int32_t *lhs, const int32_t *rhs, size_t n) {
+  // 32 x 32 -> 64 bit products of sign extended lanes, 64 bit sums
+  __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+  __m256i acc2 = _mm256_setzero_si256(), acc3 = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    acc0 = _mm256_add_epi64(acc0, _mm256_mul_epi32(loadWiden(lhs + i), loadWiden(rhs + i)));
+    acc1 = _mm256_add_epi64(acc1, _mm256_mul_epi32(loadWiden(lhs + i + 4), loadWiden(rhs + i + 4)));
+    acc2 = _mm256_add_epi64(acc2, _mm256_mul_epi32(loadWiden(lhs + i + 8), loadWiden(rhs + i + 8)));
+    acc3 = _mm256_add_epi64(acc3, _mm256_mul_epi32(loadWiden(lhs + i + 12), loadWiden(rhs + i + 12)));
+  }
+  const __m256i acc = _mm256_add_epi64(_mm256_add_epi64(acc0, acc1), _mm256_add_epi64(acc2, acc3));
+  alignas(32) int64_t lanes[4];
+  _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), acc);
+  int64_t res = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+  for (; i < n; i++)
+    res += int64_t(lhs[i]) * int64_t(rhs[i]);
+  return res;
+}
+
+
+/////////////////////////// int8 / int16 kernels, SSE2
+
+// Products of int8 codes are summed in int32 lanes (a madd pair is at
+// most 2 * 128 * 128 = 2^15) and flushed to int64 every int8_block
+// iterations, far before a lane could overflow. A madd pair of int16
+// codes already needs up to 2^31, the only value out of int32 range, so
+// int16 lanes are biased by -1 before widening and the bias is added
+// back after the loop
+constexpr size_t int8_block = size_t(1) << 15;
+
+// int32 lanes sign extended to int64 and added into acc
+__attribute__((target("sse2")))
+inline __m128i addWidenSse2(__m128i acc, __m128i v) {
+  const __m128i sign = _mm_srai_epi32(v, 31);
+  return _mm_add_epi64(_mm_add_epi64(acc, _mm_unpacklo_epi32(v, sign)),
+                       _mm_unpackhi_epi32(v, sign));
+}
+
+__attribute__((target("sse2")))
+inline int64_t hsumEpi64(__m128i v) {
+  alignas(16) int64_t lanes[2];
+  _mm_store_si128(reinterpret_cast<__m128i *>(lanes), v);
+  return lanes[0] + lanes[1];
+}
+
+__attribute__((target("sse2")))
+inline int64_t dotSse2(const int8_t *lhs, const int8_t *rhs, size_t n) {
+  __m128i acc = _mm_setzero_si128();
+  size_t i = 0;
+  while (i + 16 <= n) {
+    __m128i acc0 = _mm_setzero_si128(), acc1 = _mm_setzero_si128();
+    for (size_t it = 0; it < int8_block && i + 16 <= n; it++, i += 16) {
+      const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lhs + i));
+      const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i *>(rhs + i));
+      // sign extension to int16: byte into the high half, arithmetic shift
+      const __m128i l0 = _mm_srai_epi16(_mm_unpacklo_epi8(l, l), 8);
+      const __m128i r0 = _mm_srai_epi16(_mm_unpacklo_epi8(r, r), 8);
+      const __m128i l1 = _mm_srai_epi16(_mm_unpackhi_epi8(l, l), 8);
+      const __m128i r1 = _mm_srai_epi16(_mm_unpackhi_epi8(r, r), 8);
+      acc0 = _mm_add_epi32(acc0, _mm_madd_epi16(l0, r0));
+      acc1 = _mm_add_epi32(acc1, _mm_madd_epi16(l1, r1));
+    }
+    acc = addWidenSse2(addWidenSse2(acc, acc0), acc1);
+  }
+  int64_t res = hsumEpi64(acc);
+  for (; i < n; i++)
+    res += int32_t(lhs[i]) * int32_t(rhs[i]);
+  return res;
+}
+
+__attribute__((target("sse2")))
+inline int64_t dotSse2(const int16_t *lhs, const int16_t *rhs, size_t n) {
+  const __m128i one = _mm_set1_epi32(1);
+  __m128i acc0 = _mm_setzero_si128(), acc1 = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m128i m0 = _mm_madd_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(lhs + i)),
+                                      _mm_loadu_si128(reinterpret_cast<const __m128i *>(rhs + i)));
+    const __m128i m1 = _mm_madd_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(lhs + i + 8)),
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(rhs + i + 8)));
+    acc0 = addWidenSse2(acc0, _mm_sub_epi32(m0, one));
+    acc1 = addWidenSse2(acc1, _mm_sub_epi32(m1, one));
+  }
+  // 8 biased madd lanes per iteration
+  int64_t res = hsumEpi64(_mm_add_epi64(acc0, acc1)) + int64_t(i / 2);
+  for (; i < n; i++)
+    res += int32_t(lhs[i]) * int32_t(rhs[i]);
+  return res;
+}
+
+/////////////////////////// int8 / int16 kernels, AVX2
+
+// int32 lanes sign extended to int64 and added into acc
+__attribute__((target("avx2,fma")))
+inline __m256i addWidenAvx2(__m256i acc, __m256i v) {
+  acc = _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(v)));
+  return _mm256_add_epi64(acc, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(v, 1)));
+}
+
+__attribute__((target("avx2,fma")))
+inline int64_t hsumEpi64(__m256i v) {
+  alignas(32) int64_t lanes[4];
+  _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), v);
+  return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+__attribute__((target("avx2,fma")))
+inline int64_t dotAvx2(const int8_t *lhs, const int8_t *rhs, size_t n) {
+  __m256i acc = _mm256_setzero_si256();
+  size_t i = 0;
+  while (i + 32 <= n) {
+    __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+    for (size_t it = 0; it < int8_block && i + 32 <= n; it++, i += 32) {
+      const __m128i *l = reinterpret_cast<const __m128i *>(lhs + i);
+      const __m128i *r = reinterpret_cast<const __m128i *>(rhs + i);
+      acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(_mm256_cvtepi8_epi16(_mm_loadu_si128(l)),
+                                                      _mm256_cvtepi8_epi16(_mm_loadu_si128(r))));
+      acc1 = _mm256_add_epi32(acc1,
+                              _mm256_madd_epi16(_mm256_cvtepi8_epi16(_mm_loadu_si128(l + 1)),
+                                                _mm256_cvtepi8_epi16(_mm_loadu_si128(r + 1))));
+    }
+    acc = addWidenAvx2(addWidenAvx2(acc, acc0), acc1);
+  }
+  int64_t res = hsumEpi64(acc);
+  for (; i < n; i++)
+    res += int32_t(lhs[i]) * int32_t(rhs[i]);
+  return res;
+}
+
+__attribute__((target("avx2,fma")))
+inline int64_t dotAvx2(const int16_t *lhs, const int16_t *rhs, size_t n) {
+  const __m256i one = _mm256_set1_epi32(1);
+  __m256i acc0 = _mm256_setzero_si256(), acc1 = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i *l = reinterpret_cast<const __m256i *>(lhs + i);
+    const __m256i *r = reinterpret_cast<const __m256i *>(rhs + i);
+    const __m256i m0 = _mm256_madd_epi16(_mm256_loadu_si256(l), _mm256_loadu_si256(r));
+    const __m256i m1 = _mm256_madd_epi16(_mm256_loadu_si256(l + 1), _mm256_loadu_si256(r + 1));
+    acc0 = addWidenAvx2(acc0, _mm256_sub_epi32(m0, one));
+    acc1 = addWidenAvx2(acc1, _mm256_sub_epi32(m1, one));
+  }
+  // 16 biased madd lanes per iteration
+  int64_t res = hsumEpi64(_mm256_add_epi64(acc0, acc1)) + int64_t(i / 2);
+  for (; i < n; i++)
+    res += int32_t(lhs[i]) * int32_t(rhs[i]);
+  return res;
+}
+
+#endif // TASK_SIMD_X86
+
+/**
+ * Highest isa allowed by VECTOR_OPS_ISA environment variable
+ * ("generic", "sse2" or "avx2")
+ */
+inline Isa isaLimit() {
+  const char *limit = std::getenv("VECTOR_OPS_ISA");
+  if (limit && !std::strcmp(limit, "generic"))
+    return Isa::Generic;
+  if (limit && !std::strcmp(limit, "sse2"))
+    return Isa::Sse2;
+  return Isa::Avx2;
+}
+
+} // namespace detail
+
+/**
+ * Check if kernels of @isa can run on this CPU
+ */
+inline bool supported(Isa isa) {
+#ifdef TASK_SIMD_X86
+  __builtin_cpu_init();
+  switch (isa) {
+    case Isa::Generic:
+      return true;
+    case Isa::Sse2:
+      return __builtin_cpu_supports("sse2");
+    case Isa::Avx2:
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  }
+  return false;
+#else
+  return isa == Isa::Generic;
+#endif
+}
+
+/**
+ * Best supported isa, capped by VECTOR_OPS_ISA, selected once per process
+ */
+inline Isa active() {
+  static const Isa isa = [] {
+    const Isa limit = detail::isaLimit();
+    for (Isa candidate : {Isa::Avx2, Isa::Sse2}) {
+      if (candidate <= limit && supported(candidate))
+        return candidate;
+    }
+    return Isa::Generic;
+  }();
+  return isa;
+}
+
+/**
+ * Dot product sum_i(lhs[i] * rhs[i]) accumulated in DotType<T>.
+ * double, float, int8_t and int16_t have SSE2 / AVX2 kernels, int32_t
+ * only AVX2, other types use the portable kernel. @isa must be supported()
+ */
+template <typename T>
+DotType<T> dot(const T *lhs, const T *rhs, size_t n, Isa isa = active()) {
+#ifdef TASK_SIMD_X86
+  if constexpr (std::is_same<T, double>::value || std::is_same<T, float>::value) {
+    if (isa == Isa::Avx2)
+      return detail::dotAvx2(lhs, rhs, n);
+    if (isa == Isa::Sse2)
+      return detail::dotSse2(lhs, rhs, n);
+  } else if constexpr (std::is_same<T, int8_t>::value || std::is_same<T, int16_t>::value) {
+    if (isa == Isa::Avx2)
+      return detail::dotAvx2(lhs, rhs, n);
+    if (isa == Isa::Sse2)
+      return detail::dotSse2(lhs, rhs, n);
+  } else if constexpr (std::is_same<T, int32_t>::value) {
+    if (isa == Isa::Avx2)
+      return detail::dotAvx2(lhs, rhs, n);
+  }
+#else
+  (void)isa;
+#endif
+  return detail::dotGeneric(lhs, rhs, n);
+}
+
+} // namespace simd
+} // namespace task
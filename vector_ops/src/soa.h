@@ -0,0 +1,372 @@
+#pragma once
+
+#include <cassert>     //< for assert
+#include <cmath>       //< for std::sqrt
+#include <type_traits> //< for std::is_floating_point
+#include <vector>      //< for std::vector
+
+#include "blas.h"
+#include "vec.h"
+
+namespace task {
+
+/**
+ * Array of 3D vectors stored as structure of arrays: x, y and z
+ * coordinates live in separate contiguous vectors, so batch kernels
+ * below process one vector per simd lane without shuffles
+ */
+template <typename T>
+class Vec3Array {
+  std::vector<T> m_x, m_y, m_z;
+
+public:
+  Vec3Array() = default;
+
+  explicit Vec3Array(size_t n, const Vec<3, T> &value = {})
+    : m_x(n, value[0]), m_y(n, value[1]), m_z(n, value[2]) {}
+
+  /**
+   * Convert from array of 3D vectors, each must have exactly 3 values
+   */
+  explicit Vec3Array(const std::vector<std::vector<T>> &vectors) {
+    reserve(vectors.size());
+    for (const auto &v : vectors) {
+      assert(v.size() == 3);
+      m_x.push_back(v[0]);
+      m_y.push_back(v[1]);
+      m_z.push_back(v[2]);
+    }
+  }
+
+  /**
+   * Convert back to array of 3D vectors
+   */
+  std::vector<std::vector<T>> toVectors() const {
+    std::vector<std::vector<T>> res(size());
+    for (size_t i = 0; i < size(); i++)
+      res[i] = {m_x[i], m_y[i], m_z[i]};
+    return res;
+  }
+
+  size_t size() const {
+    return m_x.size();
+  }
+
+  bool empty() const {
+    return m_x.empty();
+  }
+
+  void resize(size_t n) {
+    m_x.resize(n);
+    m_y.resize(n);
+    m_z.resize(n);
+  }
+
+  void reserve(size_t n) {
+    m_x.reserve(n);
+    m_y.reserve(n);
+    m_z.reserve(n);
+  }
+
+  void push_back(const Vec<3, T> &v) {
+    m_x.push_back(v[0]);
+    m_y.push_back(v[1]);
+    m_z.push_back(v[2]);
+  }
+
+  Vec<3, T> operator[](size_t i) const {
+    return {{m_x[i], m_y[i], m_z[i]}};
+  }
+
+  void set(size_t i, const Vec<3, T> &v) {
+    m_x[i] = v[0];
+    m_y[i] = v[1];
+    m_z[i] = v[2];
+  }
+
+  std::vector<T> &x() {
+    return m_x;
+  }
+
+  const std::vector<T> &x() const {
+    return m_x;
+  }
+
+  std::vector<T> &y() {
+    return m_y;
+  }
+
+  const std::vector<T> &y() const {
+    return m_y;
+  }
+
+  std::vector<T> &z() {
+    return m_z;
+  }
+
+  const std::vector<T> &z() const {
+    return m_z;
+  }
+};
+
+namespace detail {
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+/**
+ * Square root per lane. Vector types have no generic sqrt, wide lanes
+ * map to the packed instruction of the matching isa
+ */
+template <typename T>
+__attribute__((always_inline)) inline T sqrtLanes(T v) {
+  return std::sqrt(v);
+}
+
+#ifdef TASK_SIMD_X86
+__attribute__((always_inline)) inline LanesOf<double, 16>::type
+sqrtLanes(LanesOf<double, 16>::type v) {
+  return (LanesOf<double, 16>::type)_mm_sqrt_pd((__m128d)v);
+}
+
+__attribute__((always_inline)) inline LanesOf<float, 16>::type
+sqrtLanes(LanesOf<float, 16>::type v) {
+  return (LanesOf<float, 16>::type)_mm_sqrt_ps((__m128)v);
+}
+
+__attribute__((target("avx"))) inline LanesOf<double, 32>::type
+sqrtLanes(LanesOf<double, 32>::type v) {
+  return (LanesOf<double, 32>::type)_mm256_sqrt_pd((__m256d)v);
+}
+
+__attribute__((target("avx"))) inline LanesOf<float, 32>::type
+sqrtLanes(LanesOf<float, 32>::type v) {
+  return (LanesOf<float, 32>::type)_mm256_sqrt_ps((__m256)v);
+}
+#endif
+
+/**
+ * o = a x b per element, every operand is loaded before the store,
+ * so o may alias a or b
+ */
+struct Cross3Kernel {
+  template <typename V, typename T>
+  __attribute__((always_inline)) static void run(size_t n, const T *ax, const T *ay, const T *az,
+                                                 const T *bx, const T *by, const T *bz,
+                                                 T *ox, T *oy, T *oz) {
+    size_t i = 0;
+    for (; i + lanes<V, T>() <= n; i += lanes<V, T>()) {
+      const V x1 = loadLanes<V>(ax + i), y1 = loadLanes<V>(ay + i), z1 = loadLanes<V>(az + i);
+      const V x2 = loadLanes<V>(bx + i), y2 = loadLanes<V>(by + i), z2 = loadLanes<V>(bz + i);
+      storeLanes(ox + i, y1 * z2 - z1 * y2);
+      storeLanes(oy + i, z1 * x2 - x1 * z2);
+      storeLanes(oz + i, x1 * y2 - y1 * x2);
+    }
+    for (; i < n; i++) {
+      const T x1 = ax[i], y1 = ay[i], z1 = az[i], x2 = bx[i], y2 = by[i], z2 = bz[i];
+      ox[i] = y1 * z2 - z1 * y2;
+      oy[i] = z1 * x2 - x1 * z2;
+      oz[i] = x1 * y2 - y1 * x2;
+    }
+  }
+};
+
+/**
+ * out[i] = a[i] * b[i]
+ */
+struct Dot3Kernel {
+  template <typename V, typename T>
+  __attribute__((always_inline)) static void run(size_t n, const T *ax, const T *ay, const T *az,
+                                                 const T *bx, const T *by, const T *bz, T *out) {
+    size_t i = 0;
+    for (; i + lanes<V, T>() <= n; i += lanes<V, T>())
+      storeLanes(out + i, loadLanes<V>(ax + i) * loadLanes<V>(bx + i) +
+                          loadLanes<V>(ay + i) * loadLanes<V>(by + i) +
+                          loadLanes<V>(az + i) * loadLanes<V>(bz + i));
+    for (; i < n; i++)
+      out[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+  }
+};
+
+/**
+ * v[i] *= 1 / |v[i]|, zero vectors are left as is
+ */
+struct Normalize3Kernel {
+  template <typename V, typename T>
+  __attribute__((always_inline)) static void run(size_t n, T *x, T *y, T *z) {
+    size_t i = 0;
+    for (; i + lanes<V, T>() <= n; i += lanes<V, T>()) {
+      const V xi = loadLanes<V>(x + i), yi = loadLanes<V>(y + i), zi = loadLanes<V>(z + i);
+      const V len2 = xi * xi + yi * yi + zi * zi;
+      const V inv = T(1) / sqrtLanes(len2 > 0 ? len2 : T(1));
+      storeLanes(x + i, xi * inv);
+      storeLanes(y + i, yi * inv);
+      storeLanes(z + i, zi * inv);
+    }
+    for (; i < n; i++) {
+      const T len2 = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+      const T inv = T(1) / std::sqrt(len2 > 0 ? len2 : T(1));
+      x[i] *= inv;
+      y[i] *= inv;
+      z[i] *= inv;
+    }
+  }
+};
+
+/**
+ * Collinearity of a[i] and b[i] in double by the CollinearityMult rule:
+ * the pivot p is the first component nonzero in any of the vectors, then
+ * |a_k * b_p - b_k * a_p| <= eps * |b_k * b_p| + slack for every component,
+ * so the ratio differences are at most eps. Elements up to 1e-64 count as
+ * zero, so do vectors with squared norm up to 1e-64: collinear with
+ * anything, codirected with nothing. With @Codirected also a_p * b_p > 0
+ */
+template <bool Codirected>
+struct Collinear3Kernel {
+  static constexpr double eps = 1.e-7;
+  static constexpr double zero = 1.e-64;
+
+  // Component k of a and b fits the pivot ratio ap / bp
+  template <typename D, typename M>
+  __attribute__((always_inline)) static void fits(const D &ak, const D &bk, const D &ap,
+                                                  const D &bp, const D &slack, M &res) {
+    const D cross = ak * bp - bk * ap, bound = bk * bp * eps;
+    res = (cross < 0 ? -cross : cross) <= (bound < 0 ? -bound : bound) + slack;
+  }
+
+  template <typename D, typename M>
+  __attribute__((always_inline)) static void check(const D &x1, const D &y1, const D &z1,
+                                                   const D &x2, const D &y2, const D &z2, M &res) {
+    const M x_pivot = (x1 > zero) | (x1 < -zero) | (x2 > zero) | (x2 < -zero);
+    const M y_pivot = (y1 > zero) | (y1 < -zero) | (y2 > zero) | (y2 < -zero);
+    const D ap = x_pivot ? x1 : (y_pivot ? y1 : z1);
+    const D bp = x_pivot ? x2 : (y_pivot ? y2 : z2);
+    const D slack = zero * ((ap < 0 ? -ap : ap) + (bp < 0 ? -bp : bp));
+    M fit_x, fit_y, fit_z;
+    fits(x1, x2, ap, bp, slack, fit_x);
+    fits(y1, y2, ap, bp, slack, fit_y);
+    fits(z1, z2, ap, bp, slack, fit_z);
+    const D n1 = x1 * x1 + y1 * y1 + z1 * z1, n2 = x2 * x2 + y2 * y2 + z2 * z2;
+    if constexpr (Codirected)
+      res = fit_x & fit_y & fit_z & (ap * bp > 0) & (n1 > zero) & (n2 > zero);
+    else
+      res = (fit_x & fit_y & fit_z) | (n1 <= zero) | (n2 <= zero);
+  }
+
+#ifdef TASK_SIMD_X86
+  template <typename V, typename T>
+  __attribute__((always_inline)) static size_t runLanes(size_t n, const T *ax, const T *ay,
+                                                        const T *az, const T *bx, const T *by,
+                                                        const T *bz, char *out) {
+    constexpr size_t w = lanes<V, T>();
+    using DV = typename LanesOf<double, w * sizeof(double)>::type;
+    using MV = typename LanesOf<long long, w * sizeof(double)>::type;
+    size_t i = 0;
+    for (; i + w <= n; i += w) {
+      const DV x1 = __builtin_convertvector(loadLanes<V>(ax + i), DV);
+      const DV y1 = __builtin_convertvector(loadLanes<V>(ay + i), DV);
+      const DV z1 = __builtin_convertvector(loadLanes<V>(az + i), DV);
+      const DV x2 = __builtin_convertvector(loadLanes<V>(bx + i), DV);
+      const DV y2 = __builtin_convertvector(loadLanes<V>(by + i), DV);
+      const DV z2 = __builtin_convertvector(loadLanes<V>(bz + i), DV);
+      MV mask;
+      check(x1, y1, z1, x2, y2, z2, mask);
+      for (size_t k = 0; k < w; k++)
+        out[i + k] = mask[k] != 0;
+    }
+    return i;
+  }
+#endif
+
+  template <typename V, typename T>
+  __attribute__((always_inline)) static void run(size_t n, const T *ax, const T *ay, const T *az,
+                                                 const T *bx, const T *by, const T *bz,
+                                                 char *out) {
+    size_t i = 0;
+#ifdef TASK_SIMD_X86
+    if constexpr (lanes<V, T>() > 1)
+      i = runLanes<V>(n, ax, ay, az, bx, by, bz, out);
+#endif
+    for (; i < n; i++) {
+      bool res;
+      check<double>(ax[i], ay[i], az[i], bx[i], by[i], bz[i], res);
+      out[i] = res;
+    }
+  }
+};
+
+#pragma GCC diagnostic pop
+
+} // namespace detail
+
+/**
+ * Batch kernels over Vec3Array, vectorized across elements for the active
+ * simd isa. Results go to a caller provided destination resized when
+ * needed, the destination may alias an operand
+ */
+
+/**
+ * Cross products, out[i] = a[i] x b[i]
+ */
+template <typename T>
+Vec3Array<T> &cross(Vec3Array<T> &out, const Vec3Array<T> &a, const Vec3Array<T> &b) {
+  assert(a.size() == b.size());
+  out.resize(a.size());
+  detail::runKernel<detail::Cross3Kernel, T>(
+      a.size(), a.x().data(), a.y().data(), a.z().data(), b.x().data(), b.y().data(),
+      b.z().data(), out.x().data(), out.y().data(), out.z().data());
+  return out;
+}
+
+/**
+ * Scalar products, out[i] = a[i] * b[i], computed in T
+ */
+template <typename T>
+std::vector<T> &dot(std::vector<T> &out, const Vec3Array<T> &a, const Vec3Array<T> &b) {
+  assert(a.size() == b.size());
+  out.resize(a.size());
+  detail::runKernel<detail::Dot3Kernel, T>(a.size(), a.x().data(), a.y().data(), a.z().data(),
+                                           b.x().data(), b.y().data(), b.z().data(), out.data());
+  return out;
+}
+
+/**
+ * Scale every nonzero vector of @v to unit length, floating point only
+ */
+template <typename T>
+Vec3Array<T> &normalize(Vec3Array<T> &v) {
+  static_assert(std::is_floating_point<T>::value, "Floating point required.");
+  detail::runKernel<detail::Normalize3Kernel, T>(v.size(), v.x().data(), v.y().data(),
+                                                 v.z().data());
+  return v;
+}
+
+/**
+ * Collinearity flags, out[i] = 1 if a[i] || b[i] else 0
+ */
+template <typename T>
+std::vector<char> &collinear(std::vector<char> &out, const Vec3Array<T> &a,
+                             const Vec3Array<T> &b) {
+  assert(a.size() == b.size());
+  out.resize(a.size());
+  detail::runKernel<detail::Collinear3Kernel<false>, T>(
+      a.size(), a.x().data(), a.y().data(), a.z().data(), b.x().data(), b.y().data(),
+      b.z().data(), out.data());
+  return out;
+}
+
+/**
+ * Same direction flags, out[i] = 1 if a[i] && b[i] else 0
+ */
+template <typename T>
+std::vector<char> &codirected(std::vector<char> &out, const Vec3Array<T> &a,
+                              const Vec3Array<T> &b) {
+  assert(a.size() == b.size());
+  out.resize(a.size());
+  detail::runKernel<detail::Collinear3Kernel<true>, T>(
+      a.size(), a.x().data(), a.y().data(), a.z().data(), b.x().data(), b.y().data(),
+      b.z().data(), out.data());
+  return out;
+}
+
+} // namespace task
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>       //< for std::array
+#include <cassert>     //< for assert
+#include <cstddef>     //< for size_t
+#include <type_traits> //< for std::enable_if_t, std::is_convertible, std::remove_cv_t
+#include <vector>      //< for std::vector
+
+namespace task {
+
+/**
+ * Non-owning view of contiguous elements, a C++17 stand-in for std::span
+ * with dynamic extent. Built from pointer and size, pointer range, array
+ * or std::vector with any allocator; Span<T> converts to Span<const T>.
+ * vector_ops operations have Span overloads working in place on memory
+ * owned elsewhere (matrix rows, mapped files, arenas)
+ */
+template <typename T>
+class Span {
+  T *m_data = nullptr;
+  size_t m_size = 0;
+
+  // U elements can be viewed as T: same type up to added const
+  template <typename U>
+  using EnableFrom = std::enable_if_t<std::is_convertible<U (*)[], T (*)[]>::value>;
+
+public:
+  using element_type = T;
+  using value_type = std::remove_cv_t<T>;
+
+  static constexpr size_t npos = size_t(-1);
+
+  constexpr Span() = default;
+
+  constexpr Span(T *data, size_t size) : m_data(data), m_size(size) {}
+
+  constexpr Span(T *first, T *last) : m_data(first), m_size(last - first) {}
+
+  template <size_t N>
+  constexpr Span(T (&array)[N]) : m_data(array), m_size(N) {}
+
+  template <typename U, size_t N, typename = EnableFrom<U>>
+  constexpr Span(std::array<U, N> &array) : m_data(array.data()), m_size(N) {}
+
+  template <typename U, size_t N, typename = EnableFrom<const U>>
+  constexpr Span(const std::array<U, N> &array) : m_data(array.data()), m_size(N) {}
+
+  template <typename U, typename Alloc, typename = EnableFrom<U>>
+  Span(std::vector<U, Alloc> &v) : m_data(v.data()), m_size(v.size()) {}
+
+  template <typename U, typename Alloc, typename = EnableFrom<const U>>
+  Span(const std::vector<U, Alloc> &v) : m_data(v.data()), m_size(v.size()) {}
+
+  template <typename U, typename = EnableFrom<U>>
+  constexpr Span(const Span<U> &other) : m_data(other.data()), m_size(other.size()) {}
+
+  constexpr T *data() const {
+    return m_data;
+  }
+
+  constexpr size_t size() const {
+    return m_size;
+  }
+
+  constexpr bool empty() const {
+    return m_size == 0;
+  }
+
+  constexpr T &operator[](size_t i) const {
+    return m_data[i];
+  }
+
+  constexpr T *begin() const {
+    return m_data;
+  }
+
+  constexpr T *end() const {
+    return m_data + m_size;
+  }
+
+  /**
+   * @count elements from @offset, up to the end by default
+   */
+  constexpr Span subspan(size_t offset, size_t count = npos) const {
+    assert(offset <= m_size);
+    return {m_data + offset, count == npos ? m_size - offset : count};
+  }
+
+  constexpr Span first(size_t count) const {
+    assert(count <= m_size);
+    return {m_data, count};
+  }
+
+  constexpr Span last(size_t count) const {
+    assert(count <= m_size);
+    return {m_data + m_size - count, count};
+  }
+
+  std::vector<value_type> toVector() const {
+    return std::vector<value_type>(begin(), end());
+  }
+};
+
+template <typename T, typename Alloc>
+Span(std::vector<T, Alloc> &) -> Span<T>;
+
+template <typename T, typename Alloc>
+Span(const std::vector<T, Alloc> &) -> Span<const T>;
+
+template <typename T, size_t N>
+Span(std::array<T, N> &) -> Span<T>;
+
+template <typename T, size_t N>
+Span(const std::array<T, N> &) -> Span<const T>;
+
+namespace detail {
+
+// Common element type of two spans, SFINAE out when they differ
+template <typename L, typename R>
+using SpanValue = std::enable_if_t<std::is_same<std::remove_cv_t<L>, std::remove_cv_t<R>>::value,
+                                   std::remove_cv_t<L>>;
+
+} // namespace detail
+
+} // namespace task
@@ -0,0 +1,428 @@
+#pragma once
+
+#include <algorithm>   //< for std::lower_bound, std::min
+#include <cassert>     //< for assert
+#include <cmath>       //< for fabs
+#include <cstdint>     //< for uint32_t, int32_t
+#include <optional>    //< for std::optional
+#include <type_traits> //< for std::is_same, std::is_arithmetic, std::remove_cv_t
+#include <vector>      //< for std::vector
+
+#include "collinearity.h"
+#include "simd.h"
+#include "span.h"
+
+namespace task {
+
+/**
+ * Sparse vector of dimension size(): strictly increasing indices of the
+ * nonzero elements and their values. Explicit zeros are never stored,
+ * so memory and all operations scale with nnz()
+ */
+template <typename T, typename Index = uint32_t>
+class SparseVector {
+  static_assert(std::is_arithmetic<T>::value, "Arithmetic type required.");
+
+  size_t m_size = 0;
+  std::vector<Index> m_indices;
+  std::vector<T> m_values;
+
+public:
+  using value_type = T;
+  using index_type = Index;
+
+  SparseVector() = default;
+
+  explicit SparseVector(size_t size) : m_size(size) {}
+
+  /**
+   * Nonzero elements of @dense
+   */
+  template <typename U>
+  explicit SparseVector(Span<U> dense) : m_size(dense.size()) {
+    for (size_t i = 0; i < dense.size(); i++) {
+      if (dense[i] != T(0))
+        push_back(i, dense[i]);
+    }
+  }
+
+  template <typename Alloc>
+  explicit SparseVector(const std::vector<T, Alloc> &dense) : SparseVector(Span<const T>(dense)) {}
+
+  std::vector<T> toDense() const {
+    std::vector<T> dense(m_size);
+    for (size_t k = 0; k < nnz(); k++)
+      dense[m_indices[k]] = m_values[k];
+    return dense;
+  }
+
+  /**
+   * Append element, @index must exceed all stored ones, zeros are skipped
+   */
+  void push_back(size_t index, const T &value) {
+    assert(index < m_size && (m_indices.empty() || index > m_indices.back()));
+    if (value == T(0))
+      return;
+    m_indices.push_back(static_cast<Index>(index));
+    m_values.push_back(value);
+  }
+
+  void reserve(size_t nnz) {
+    m_indices.reserve(nnz);
+    m_values.reserve(nnz);
+  }
+
+  void clear() {
+    m_indices.clear();
+    m_values.clear();
+  }
+
+  size_t size() const {
+    return m_size;
+  }
+
+  size_t nnz() const {
+    return m_indices.size();
+  }
+
+  const std::vector<Index> &indices() const {
+    return m_indices;
+  }
+
+  const std::vector<T> &values() const {
+    return m_values;
+  }
+
+  std::vector<T> &values() {
+    return m_values;
+  }
+
+  /**
+   * Value at @index, binary search over the stored indices
+   */
+  T operator[](size_t index) const {
+    const auto it = std::lower_bound(m_indices.begin(), m_indices.end(), index);
+    return it != m_indices.end() && *it == index ? m_values[it - m_indices.begin()] : T(0);
+  }
+
+  friend bool operator==(const SparseVector &lhs, const SparseVector &rhs) {
+    return lhs.m_size == rhs.m_size && lhs.m_indices == rhs.m_indices &&
+           lhs.m_values == rhs.m_values;
+  }
+
+  friend bool operator!=(const SparseVector &lhs, const SparseVector &rhs) {
+    return !(lhs == rhs);
+  }
+};
+
+namespace detail {
+
+/**
+ * Portable gather dot, sum_k values[k] * dense[indices[k]]
+ */
+template <typename T, typename Index>
+simd::DotType<T> gatherDotGeneric(const T *values, const Index *indices, size_t nnz,
+                                  const T *dense) {
+  using Acc = simd::DotType<T>;
+  Acc acc0 = 0, acc1 = 0, acc2 = 0, acc3 = 0;
+  size_t k = 0;
+  for (; k + 4 <= nnz; k += 4) {
+    acc0 += Acc(values[k]) * Acc(dense[indices[k]]);
+    acc1 += Acc(values[k + 1]) * Acc(dense[indices[k + 1]]);
+    acc2 += Acc(values[k + 2]) * Acc(dense[indices[k + 2]]);
+    acc3 += Acc(values[k + 3]) * Acc(dense[indices[k + 3]]);
+  }
+  for (; k < nnz; k++)
+    acc0 += Acc(values[k]) * Acc(dense[indices[k]]);
+  return (acc0 + acc1) + (acc2 + acc3);
+}
+
+#ifdef TASK_SIMD_X86
+
+// AVX2 gathers take signed 32-bit indices, so dense size must fit int32_t.
+// Masked forms with a zero source: the plain ones start from an undefined
+// register that GCC reports as maybe-uninitialized
+
+__attribute__((target("avx2,fma")))
+inline double gatherDotAvx2(const double *values, const uint32_t *indices, size_t nnz,
+                            const double *dense) {
+  const __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1)), zero = _mm256_setzero_pd();
+  __m256d acc0 = zero, acc1 = zero;
+  size_t k = 0;
+  for (; k + 8 <= nnz; k += 8) {
+    const __m128i i0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(indices + k));
+    const __m128i i1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(indices + k + 4));
+    const __m256d g0 = _mm256_mask_i32gather_pd(zero, dense, i0, all, 8);
+    const __m256d g1 = _mm256_mask_i32gather_pd(zero, dense, i1, all, 8);
+    acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(values + k), g0, acc0);
+    acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(values + k + 4), g1, acc1);
+  }
+  double res = simd::detail::hsum(_mm256_add_pd(acc0, acc1));
+  for (; k < nnz; k++)
+    res += values[k] * dense[indices[k]];
+  return res;
+}
+
+__attribute__((target("avx2,fma")))
+inline double gatherDotAvx2(const float *values, const uint32_t *indices, size_t nnz,
+                            const float *dense) {
+  const __m256 all = _mm256_castsi256_ps(_mm256_set1_epi32(-1)), zero = _mm256_setzero_ps();
+  __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+  size_t k = 0;
+  for (; k + 8 <= nnz; k += 8) {
+    const __m256i idx = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(indices + k));
+    const __m256 g = _mm256_mask_i32gather_ps(zero, dense, idx, all, 4);
+    const __m256 v = _mm256_loadu_ps(values + k);
+    acc0 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(v)),
+                           _mm256_cvtps_pd(_mm256_castps256_ps128(g)), acc0);
+    acc1 = _mm256_fmadd_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)),
+                           _mm256_cvtps_pd(_mm256_extractf128_ps(g, 1)), acc1);
+  }
+  double res = simd::detail::hsum(_mm256_add_pd(acc0, acc1));
+  for (; k < nnz; k++)
+    res += double(values[k]) * double(dense[indices[k]]);
+  return res;
+}
+
+#endif // TASK_SIMD_X86
+
+/**
+ * First position in [@first, @last) with *pos >= @value: exponential
+ * probe from @first, then binary search in the bracketed range
+ */
+template <typename Index>
+const Index *gallop(const Index *first, const Index *last, Index value) {
+  size_t step = 1;
+  const Index *lo = first;
+  while (first + step < last && first[step] < value) {
+    lo = first + step;
+    step *= 2;
+  }
+  return std::lower_bound(lo, std::min(first + step + 1, last), value);
+}
+
+// nnz ratio from which sparse-sparse dot gallops instead of merging
+constexpr size_t gallop_ratio = 32;
+
+} // namespace detail
+
+/**
+ * Sparse-dense scalar product, vectorized gathers for float and double
+ */
+template <typename T, typename Index, typename U>
+simd::DotType<T> dot(const SparseVector<T, Index> &lhs, Span<U> rhs) {
+  static_assert(std::is_same<std::remove_cv_t<U>, T>::value, "Same element type required.");
+  assert(lhs.size() == rhs.size());
+#ifdef TASK_SIMD_X86
+  if constexpr ((std::is_same<T, double>::value || std::is_same<T, float>::value) &&
+                std::is_same<Index, uint32_t>::value) {
+    if (simd::active() == simd::Isa::Avx2 && rhs.size() <= size_t(INT32_MAX))
+      return detail::gatherDotAvx2(lhs.values().data(), lhs.indices().data(), lhs.nnz(),
+                                   static_cast<const T *>(rhs.data()));
+  }
+#endif
+  return detail::gatherDotGeneric(lhs.values().data(), lhs.indices().data(), lhs.nnz(),
+                                  static_cast<const T *>(rhs.data()));
+}
+
+/**
+ * Sparse-sparse scalar product over the common indices: linear merge for
+ * similar nnz, galloping search of the longer index list otherwise
+ */
+template <typename T, typename Index>
+simd::DotType<T> dot(const SparseVector<T, Index> &lhs, const SparseVector<T, Index> &rhs) {
+  using Acc = simd::DotType<T>;
+  assert(lhs.size() == rhs.size());
+  if (lhs.nnz() > rhs.nnz())
+    return dot(rhs, lhs);
+  const Index *li = lhs.indices().data(), *ri = rhs.indices().data();
+  const size_t ln = lhs.nnz(), rn = rhs.nnz();
+  Acc res = 0;
+  if (ln * detail::gallop_ratio < rn) {
+    const Index *pos = ri, *end = ri + rn;
+    for (size_t k = 0; k < ln && pos != end; k++) {
+      pos = detail::gallop(pos, end, li[k]);
+      if (pos != end && *pos == li[k])
+        res += Acc(lhs.values()[k]) * Acc(rhs.values()[pos - ri]);
+    }
+    return res;
+  }
+  for (size_t a = 0, b = 0; a < ln && b < rn;) {
+    if (li[a] < ri[b]) {
+      a++;
+    } else if (ri[b] < li[a]) {
+      b++;
+    } else {
+      res += Acc(lhs.values()[a++]) * Acc(rhs.values()[b++]);
+    }
+  }
+  return res;
+}
+
+/**
+ * Binary operators of scalar product, as for std::vector result is double
+ */
+template <typename T, typename Index>
+double operator*(const SparseVector<T, Index> &lhs, const SparseVector<T, Index> &rhs) {
+  return static_cast<double>(dot(lhs, rhs));
+}
+
+template <typename T, typename Index, typename Alloc>
+double operator*(const SparseVector<T, Index> &lhs, const std::vector<T, Alloc> &rhs) {
+  return static_cast<double>(dot(lhs, Span<const T>(rhs)));
+}
+
+template <typename T, typename Index, typename Alloc>
+double operator*(const std::vector<T, Alloc> &lhs, const SparseVector<T, Index> &rhs) {
+  return rhs * lhs;
+}
+
+namespace detail {
+
+/**
+ * Merge of two sparse vectors, res = lhs + sign * rhs, cancelled
+ * elements are dropped
+ */
+template <typename T, typename Index>
+SparseVector<T, Index> sparseMerge(const SparseVector<T, Index> &lhs,
+                                   const SparseVector<T, Index> &rhs, bool subtract) {
+  assert(lhs.size() == rhs.size());
+  SparseVector<T, Index> res(lhs.size());
+  res.reserve(lhs.nnz() + rhs.nnz());
+  const auto &li = lhs.indices(), &ri = rhs.indices();
+  const auto &lv = lhs.values(), &rv = rhs.values();
+  size_t a = 0, b = 0;
+  while (a < li.size() || b < ri.size()) {
+    if (b == ri.size() || (a < li.size() && li[a] < ri[b])) {
+      res.push_back(li[a], lv[a]);
+      a++;
+    } else if (a == li.size() || ri[b] < li[a]) {
+      res.push_back(ri[b], subtract ? T(-rv[b]) : rv[b]);
+      b++;
+    } else {
+      res.push_back(li[a], subtract ? T(lv[a] - rv[b]) : T(lv[a] + rv[b]));
+      a++;
+      b++;
+    }
+  }
+  return res;
+}
+
+} // namespace detail
+
+/**
+ * Sparse plus and minus, result nnz is at most the sum of operands nnz
+ */
+template <typename T, typename Index>
+SparseVector<T, Index> operator+(const SparseVector<T, Index> &lhs,
+                                 const SparseVector<T, Index> &rhs) {
+  return detail::sparseMerge(lhs, rhs, false);
+}
+
+template <typename T, typename Index>
+SparseVector<T, Index> operator-(const SparseVector<T, Index> &lhs,
+                                 const SparseVector<T, Index> &rhs) {
+  return detail::sparseMerge(lhs, rhs, true);
+}
+
+/**
+ * Scaling, v[i] *= scalar. Scaling by zero clears @v
+ */
+template <typename T, typename Index>
+SparseVector<T, Index> &operator*=(SparseVector<T, Index> &v,
+                                   const typename SparseVector<T, Index>::value_type &scalar) {
+  if (scalar == T(0)) {
+    v.clear();
+    return v;
+  }
+  for (auto &value : v.values())
+    value *= scalar;
+  return v;
+}
+
+template <typename T, typename Index>
+SparseVector<T, Index> operator*(SparseVector<T, Index> v,
+                                 const typename SparseVector<T, Index>::value_type &scalar) {
+  return v *= scalar;
+}
+
+/**
+ * Scatter update of a dense vector, y[indices[k]] += alpha * x.values[k]
+ */
+template <typename T, typename Index>
+Span<T> axpy(const typename Span<T>::value_type &alpha, const SparseVector<T, Index> &x,
+             Span<T> y) {
+  assert(x.size() == y.size());
+  for (size_t k = 0; k < x.nnz(); k++)
+    y[x.indices()[k]] += alpha * x.values()[k];
+  return y;
+}
+
+template <typename T, typename Index, typename Alloc>
+std::vector<T, Alloc> &axpy(const typename std::vector<T, Alloc>::value_type &alpha,
+                            const SparseVector<T, Index> &x, std::vector<T, Alloc> &y) {
+  axpy(alpha, x, Span<T>(y));
+  return y;
+}
+
+/**
+ * Collinearity check helper by the std::vector rule. With the same
+ * nonzero pattern stored values are compared as dense vectors, otherwise
+ * the rule runs over the union of the patterns: positions stored in
+ * neither vector are zeros in both and always fit, stored values up to
+ * 1e-64 count as zeros. Zero vector, also one with squared norm up to
+ * 1e-64, is collinear with any other
+ */
+template <typename T, typename Index>
+std::optional<double> CollinearityMult(const SparseVector<T, Index> &lhs,
+                                       const SparseVector<T, Index> &rhs) {
+  assert(lhs.size() == rhs.size());
+  if (lhs.indices() == rhs.indices())
+    return CollinearityMult(lhs.values().data(), rhs.values().data(), lhs.nnz());
+
+  static constexpr double nonzero_check_eps = 1.e-64;
+  static constexpr double ratio_diff_check_eps = 1.e-7;
+  if (detail::isZeroVector(lhs.values().data(), lhs.nnz(), nonzero_check_eps) ||
+      detail::isZeroVector(rhs.values().data(), rhs.nnz(), nonzero_check_eps))
+    return {0.};
+
+  const auto &li = lhs.indices(), &ri = rhs.indices();
+  bool has_pivot = false;
+  double lp = 0, rp = 0, slack = 0;
+  for (size_t a = 0, b = 0; a < lhs.nnz() || b < rhs.nnz();) {
+    double l = 0, r = 0;
+    if (b == rhs.nnz() || (a < lhs.nnz() && li[a] < ri[b])) {
+      l = lhs.values()[a++];
+    } else if (a == lhs.nnz() || ri[b] < li[a]) {
+      r = rhs.values()[b++];
+    } else {
+      l = lhs.values()[a++];
+      r = rhs.values()[b++];
+    }
+    if (has_pivot) {
+      if (fabs(l * rp - r * lp) > fabs(r * rp * ratio_diff_check_eps) + slack)
+        return {};
+    } else if (fabs(l) > nonzero_check_eps || fabs(r) > nonzero_check_eps) {
+      has_pivot = true;
+      lp = l;
+      rp = r;
+      slack = nonzero_check_eps * (fabs(lp) + fabs(rp));
+    }
+  }
+  if (!has_pivot)
+    return {0.};
+  return {lp / rp};
+}
+
+template <typename T, typename Index>
+bool operator||(const SparseVector<T, Index> &lhs, const SparseVector<T, Index> &rhs) {
+  return CollinearityMult(lhs, rhs).has_value();
+}
+
+template <typename T, typename Index>
+bool operator&&(const SparseVector<T, Index> &lhs, const SparseVector<T, Index> &rhs) {
+  auto opt = CollinearityMult(lhs, rhs);
+  return opt.has_value() && opt.value() > 0.;
+}
+
+} // namespace task
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <cassert>     //< for assert
+#include <cstddef>     //< for size_t
+#include <optional>    //< for std::optional
+#include <ostream>     //< for std::ostream
+#include <type_traits> //< for std::is_integral
+#include <utility>     //< for std::index_sequence
+#include <vector>      //< for std::vector
+
+namespace task {
+
+/**
+ * Fixed-size stack allocated vector, aggregate of N values of T.
+ * Operators mirror the std::vector ones from vector_ops.h, every one is
+ * constexpr and expands over the index pack, so no loops are left
+ * for the compiler to unroll
+ */
+template <size_t N, typename T>
+struct Vec {
+  static_assert(N > 0, "Empty Vec is not supported.");
+
+  T data[N];
+
+  static constexpr size_t size() {
+    return N;
+  }
+
+  constexpr T &operator[](size_t i) {
+    return data[i];
+  }
+
+  constexpr const T &operator[](size_t i) const {
+    return data[i];
+  }
+
+  constexpr T *begin() {
+    return data;
+  }
+
+  constexpr const T *begin() const {
+    return data;
+  }
+
+  constexpr T *end() {
+    return data + N;
+  }
+
+  constexpr const T *end() const {
+    return data + N;
+  }
+
+  /**
+   * Copy first N values of @v, its size must be N
+   */
+  static Vec from(const std::vector<T> &v) {
+    assert(v.size() == N);
+    return fromPointer(v.data(), std::make_index_sequence<N>{});
+  }
+
+  std::vector<T> toVector() const {
+    return std::vector<T>(begin(), end());
+  }
+
+private:
+  template <size_t... I>
+  static Vec fromPointer(const T *p, std::index_sequence<I...>) {
+    return {{p[I]...}};
+  }
+};
+
+using Vec2d = Vec<2, double>;
+using Vec3d = Vec<3, double>;
+using Vec3f = Vec<3, float>;
+using Vec3i = Vec<3, int>;
+
+namespace detail {
+
+template <size_t N, typename T, typename Functor, size_t... I>
+constexpr Vec<N, T> vecTransform(const Vec<N, T> &lhs, const Vec<N, T> &rhs, Functor func,
+                                 std::index_sequence<I...>) {
+  return {{func(lhs[I], rhs[I])...}};
+}
+
+template <size_t N, typename T, typename Functor, size_t... I>
+constexpr Vec<N, T> vecTransform(const Vec<N, T> &v, Functor func, std::index_sequence<I...>) {
+  return {{func(v[I])...}};
+}
+
+template <size_t N, typename T, size_t... I>
+constexpr double vecDot(const Vec<N, T> &lhs, const Vec<N, T> &rhs, std::index_sequence<I...>) {
+  return (0.0 + ... + (static_cast<double>(lhs[I]) * static_cast<double>(rhs[I])));
+}
+
+template <size_t N, typename T, size_t... I>
+constexpr bool vecEqual(const Vec<N, T> &lhs, const Vec<N, T> &rhs, std::index_sequence<I...>) {
+  return (... && (lhs[I] == rhs[I]));
+}
+
+constexpr double constexprAbs(double value) {
+  return value < 0 ? -value : value;
+}
+
+} // namespace detail
+
+/**
+ *  Binary operator plus
+ *  res[i] = lhs[i] + rhs[i]
+ */
+template <size_t N, typename T>
+constexpr Vec<N, T> operator+(const Vec<N, T> &lhs, const Vec<N, T> &rhs) {
+  return detail::vecTransform(lhs, rhs, [](const T &a, const T &b) { return T(a + b); },
+                              std::make_index_sequence<N>{});
+}
+
+/**
+ *  Binary operator minus
+ *  res[i] = lhs[i] - rhs[i]
+ */
+template <size_t N, typename T>
+constexpr Vec<N, T> operator-(const Vec<N, T> &lhs, const Vec<N, T> &rhs) {
+  return detail::vecTransform(lhs, rhs, [](const T &a, const T &b) { return T(a - b); },
+                              std::make_index_sequence<N>{});
+}
+
+/**
+ *  Unary operator plus
+ */
+template <size_t N, typename T>
+constexpr Vec<N, T> operator+(const Vec<N, T> &v) {
+  return v;
+}
+
+/**
+ *  Unary operator minus
+ *  res[i] = (-1) * v[i]
+ */
+template <size_t N, typename T>
+constexpr Vec<N, T> operator-(const Vec<N, T> &v) {
+  return detail::vecTransform(v, [](const T &a) { return T(-a); }, std::make_index_sequence<N>{});
+}
+
+/**
+ *  Multiplication by scalar
+ *  res[i] = v[i] * scalar
+ */
+template <size_t N, typename T>
+constexpr Vec<N, T> operator*(const Vec<N, T> &v, const T &scalar) {
+  return detail::vecTransform(v, [&scalar](const T &a) { return T(a * scalar); },
+                              std::make_index_sequence<N>{});
+}
+
+template <size_t N, typename T>
+constexpr Vec<N, T> operator*(const T &scalar, const Vec<N, T> &v) {
+  return v * scalar;
+}
+
+template <size_t N, typename T>
+constexpr Vec<N, T> &operator+=(Vec<N, T> &lhs, const Vec<N, T> &rhs) {
+  return lhs = lhs + rhs;
+}
+
+template <size_t N, typename T>
+constexpr Vec<N, T> &operator-=(Vec<N, T> &lhs, const Vec<N, T> &rhs) {
+  return lhs = lhs - rhs;
+}
+
+template <size_t N, typename T>
+constexpr Vec<N, T> &operator*=(Vec<N, T> &v, const T &scalar) {
+  return v = v * scalar;
+}
+
+/**
+ *  Binary operator of scalar product,
+ *  res = sum_i(lhs_i * rhs_i), computed in double
+ */
+template <size_t N, typename T>
+constexpr double operator*(const Vec<N, T> &lhs, const Vec<N, T> &rhs) {
+  return detail::vecDot(lhs, rhs, std::make_index_sequence<N>{});
+}
+
+/**
+ *  Binary operator of cross product, defined only for N = 3
+ */
+template <typename T>
+constexpr Vec<3, T> operator%(const Vec<3, T> &lhs, const Vec<3, T> &rhs) {
+  return {{T(lhs[1] * rhs[2] - lhs[2] * rhs[1]),
+           T(lhs[2] * rhs[0] - lhs[0] * rhs[2]),
+           T(lhs[0] * rhs[1] - lhs[1] * rhs[0])}};
+}
+
+template <size_t N, typename T>
+constexpr bool operator==(const Vec<N, T> &lhs, const Vec<N, T> &rhs) {
+  return detail::vecEqual(lhs, rhs, std::make_index_sequence<N>{});
+}
+
+template <size_t N, typename T>
+constexpr bool operator!=(const Vec<N, T> &lhs, const Vec<N, T> &rhs) {
+  return !(lhs == rhs);
+}
+
+/**
+ * Collinearity check helper, find alpha such that @lhs = alpha * @rhs,
+ * otherwise returns empty optional. Same rule as the std::vector
+ * version: division-free comparison against the first nonzero position,
+ * squared norms and elements up to 1e-64 count as zero
+ */
+template <size_t N, typename T>
+constexpr std::optional<double> CollinearityMult(const Vec<N, T> &lhs, const Vec<N, T> &rhs) {
+  constexpr double nonzero_check_eps = 1.e-64;
+  constexpr double ratio_diff_check_eps = 1.e-7;
+
+  size_t pivot = 0;
+  while (pivot < N && detail::constexprAbs(static_cast<double>(lhs[pivot])) <= nonzero_check_eps &&
+         detail::constexprAbs(static_cast<double>(rhs[pivot])) <= nonzero_check_eps)
+    pivot++;
+  if (pivot == N)
+    return {0.};
+
+  const double lp = static_cast<double>(lhs[pivot]), rp = static_cast<double>(rhs[pivot]);
+  const double slack = nonzero_check_eps * (detail::constexprAbs(lp) + detail::constexprAbs(rp));
+  bool mismatch = false;
+  for (size_t i = pivot + 1; i < N && !mismatch; i++) {
+    const double li = static_cast<double>(lhs[i]), ri = static_cast<double>(rhs[i]);
+    mismatch = detail::constexprAbs(li * rp - ri * lp) >
+               detail::constexprAbs(ri * rp * ratio_diff_check_eps) + slack;
+  }
+  if (lhs * lhs <= nonzero_check_eps || rhs * rhs <= nonzero_check_eps)
+    return {0.};
+  if (mismatch)
+    return {};
+  return {lp / rp};
+}
+
+/**
+ * Binary operator of collinearity check
+ */
+template <size_t N, typename T>
+constexpr bool operator||(const Vec<N, T> &lhs, const Vec<N, T> &rhs) {
+  return CollinearityMult(lhs, rhs).has_value();
+}
+
+/**
+ * Binary operator of same direction check
+ */
+template <size_t N, typename T>
+constexpr bool operator&&(const Vec<N, T> &lhs, const Vec<N, T> &rhs) {
+  const auto opt = CollinearityMult(lhs, rhs);
+  return opt.has_value() && *opt > 0.;
+}
+
+/**
+ * Binary operator of bitwise |, implemented only for integer types
+ */
+template <size_t N, typename T>
+constexpr Vec<N, T> operator|(const Vec<N, T> &lhs, const Vec<N, T> &rhs) {
+  static_assert(std::is_integral<T>::value, "Integral required.");
+  return detail::vecTransform(lhs, rhs, [](const T &a, const T &b) { return T(a | b); },
+                              std::make_index_sequence<N>{});
+}
+
+/**
+ * Binary operator of bitwise &, implemented only for integer types
+ */
+template <size_t N, typename T>
+constexpr Vec<N, T> operator&(const Vec<N, T> &lhs, const Vec<N, T> &rhs) {
+  static_assert(std::is_integral<T>::value, "Integral required.");
+  return detail::vecTransform(lhs, rhs, [](const T &a, const T &b) { return T(a & b); },
+                              std::make_index_sequence<N>{});
+}
+
+/**
+ * Output operator <<, values separated by space, ending with newline
+ */
+template <size_t N, typename T>
+std::ostream &operator<<(std::ostream &s, const Vec<N, T> &v) {
+  for (size_t i = 0; i < N; i++)
+    s << v[i] << " ";
+  s << '\n';
+  return s;
+}
+
+} // namespace task
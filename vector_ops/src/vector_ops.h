@@ -3,19 +3,36 @@
 #include <algorithm> //< for std::transform, std::copy, std::iter_swap
 #include <cassert>   //< for assert
 #include <cmath>     //< for fabs
+#include <istream>   //< for std::istream
 #include <numeric>   //< for std::accumulate
 #include <optional>  //< for std::optional
+#include <ostream>   //< for std::ostream
+#include <type_traits> //< for std::is_arithmetic
 #include <utility>   //< for std::plus, std::minus, std::multiplies
 #include <vector>    //< for std::vector
 
+#include "bits.h"
+#include "blas.h"
+#include "collinearity.h"
+#include "expression.h"
+#include "io.h"
+#include "parallel.h"
+#include "quantize.h"
+#include "reductions.h"
+#include "simd.h"
+#include "soa.h"
+#include "sparse.h"
+#include "span.h"
+#include "vec.h"
+
 namespace task {
 
 // Transform wrapper for vectors
-template <typename T, typename Functor>
-std::vector<T> VectorTransform(const std::vector<T> &lhs,
-                                const std::vector<T> &rhs, Functor func) {
+template <typename T, typename Alloc, typename Functor>
+std::vector<T, Alloc> VectorTransform(const std::vector<T, Alloc> &lhs,
+                                      const std::vector<T, Alloc> &rhs, Functor func) {
   assert(lhs.size() == rhs.size());
-  std::vector<T> out(lhs.size());
+  std::vector<T, Alloc> out(lhs.size(), lhs.get_allocator());
   std::transform(cbegin(lhs), cend(lhs), cbegin(rhs), begin(out), func);
   return out;
 }
@@ -24,8 +41,9 @@ std::vector<T> VectorTransform(const std::vector<T> &lhs,
  *  Binary operator plus
  *  res[i] = lhs[i] + rhs[i]
  */
-template <typename T>
-std::vector<T> operator+(const std::vector<T> &lhs, const std::vector<T> &rhs) {
+template <typename T, typename Alloc>
+std::vector<T, Alloc> operator+(const std::vector<T, Alloc> &lhs,
+                                const std::vector<T, Alloc> &rhs) {
   return VectorTransform(lhs, rhs, std::plus<>{});
 }
 
@@ -33,8 +51,9 @@ std::vector<T> operator+(const std::vector<T> &lhs, const std::vector<T> &rhs) {
  *  Binary operator minus
  *  res[i] = lhs[i] - rhs[i]
  */
-template <typename T>
-std::vector<T> operator-(const std::vector<T> &lhs, const std::vector<T> &rhs) {
+template <typename T, typename Alloc>
+std::vector<T, Alloc> operator-(const std::vector<T, Alloc> &lhs,
+                                const std::vector<T, Alloc> &rhs) {
   return VectorTransform(lhs, rhs, std::minus<>{});
 }
 
@@ -42,8 +61,8 @@ std::vector<T> operator-(const std::vector<T> &lhs, const std::vector<T> &rhs) {
  *  Unary operator plus
  *  res[i] = (+1) * v[i]
  */
-template <typename T>
-std::vector<T> operator+(const std::vector<T> &v) {
+template <typename T, typename Alloc>
+std::vector<T, Alloc> operator+(const std::vector<T, Alloc> &v) {
   return v;
 }
 
@@ -51,9 +70,9 @@ std::vector<T> operator+(const std::vector<T> &v) {
  *  Unary operator minus
  *  res[i] = (-1) * v[i]
  */
-template <typename T>
-std::vector<T> operator-(const std::vector<T> &v) {
-  std::vector<T> out(v.size());
+template <typename T, typename Alloc>
+std::vector<T, Alloc> operator-(const std::vector<T, Alloc> &v) {
+  std::vector<T, Alloc> out(v.size(), v.get_allocator());
   std::transform(cbegin(v), cend(v), begin(out),
                  [](const T &a) { return -a; });
   return out;
@@ -62,14 +81,20 @@ std::vector<T> operator-(const std::vector<T> &v) {
 /**
  *  Binary operator of scalar product,
  *  res = sum_i(lhs_i * rhs_i)
+ *  Arithmetic types go through vectorized multi-accumulator kernels,
+ *  accumulating in double (floats) or 64-bit integers (integers)
  */
-template <typename T>
-double operator*(const std::vector<T> &lhs, const std::vector<T> &rhs) {
+template <typename T, typename Alloc>
+double operator*(const std::vector<T, Alloc> &lhs, const std::vector<T, Alloc> &rhs) {
   assert(lhs.size() == rhs.size());
-  double res = 0.0;
-  for (size_t i = 0; i < lhs.size(); i++)
-    res += lhs[i] * rhs[i];
-  return res;
+  if constexpr (std::is_arithmetic<T>::value) {
+    return static_cast<double>(simd::dot(lhs.data(), rhs.data(), lhs.size()));
+  } else {
+    double res = 0.0;
+    for (size_t i = 0; i < lhs.size(); i++)
+      res += lhs[i] * rhs[i];
+    return res;
+  }
 }
 
 /**
@@ -77,69 +102,49 @@ double operator*(const std::vector<T> &lhs, const std::vector<T> &rhs) {
  *  correctly determined only for n=3,
  *  check wiki for details
  */
-template <typename T>
-std::vector<T> operator%(const std::vector<T> &lhs, const std::vector<T> &rhs) {
+template <typename T, typename Alloc>
+std::vector<T, Alloc> operator%(const std::vector<T, Alloc> &lhs,
+                                const std::vector<T, Alloc> &rhs) {
   constexpr size_t n = 3;
   constexpr size_t x = 0;
   constexpr size_t y = 1;
   constexpr size_t z = 2;
   assert(lhs.size() == n && rhs.size() == n);
-  return {lhs[y] * rhs[z] - lhs[z] * rhs[y],
-          lhs[z] * rhs[x] - lhs[x] * rhs[z],
-          lhs[x] * rhs[y] - lhs[y] * rhs[x]};
+  return std::vector<T, Alloc>({lhs[y] * rhs[z] - lhs[z] * rhs[y],
+                                lhs[z] * rhs[x] - lhs[x] * rhs[z],
+                                lhs[x] * rhs[y] - lhs[y] * rhs[x]},
+                               lhs.get_allocator());
 }
 
-/**
- * Collinearity check helper, find alpha such that @lhs = alpha * @rhs,
- * otherwise returns empty optional, if vectors are not collinear
- */
-template <typename T>
-std::optional<double> CollinearityMult(const std::vector<T> &lhs, const std::vector<T> &rhs) {
-
-  // required for in_nonzero(double) -> bool helper
-  static constexpr double nonzero_check_eps = 1.e-64;
-  // required for collinearity check algorithm
-  static constexpr double ratio_diff_check_eps = 1.e-7;
-
+template <typename T, typename Alloc>
+std::optional<double> CollinearityMult(const std::vector<T, Alloc> &lhs,
+                                       const std::vector<T, Alloc> &rhs) {
   assert(lhs.size() == rhs.size());
-  auto is_nonzero = [](double value) {
-    return fabs(value) > nonzero_check_eps;
-  };
-
-  // corner case: zero vector is collinear with any other
-  if (lhs.empty() || !is_nonzero(lhs * lhs) || rhs.empty() || !is_nonzero(rhs * rhs))
-    return {0.};
-
-  // otherwise, collinear vectors must have equal ratio factor > 0
-  auto nonzero_begin = std::find_if(begin(lhs), end(rhs), is_nonzero);
-  size_t nonzero_begin_pos = std::distance(begin(lhs), nonzero_begin);
-  if (nonzero_begin == end(lhs) || !is_nonzero(rhs[nonzero_begin_pos]))
-    return {};
-
-  const auto candidate_ratio = lhs[nonzero_begin_pos] / rhs[nonzero_begin_pos];
-
-  for (size_t i = nonzero_begin_pos + 1; i < lhs.size(); i++) {
-    if ((!is_nonzero(lhs[i]) && is_nonzero(rhs[i])) ||
-        (is_nonzero(lhs[i]) && !is_nonzero(rhs[i]))) {
-      return {};
-    }
-    else if (is_nonzero(lhs[i]) && is_nonzero(rhs[i])) {
-      double diff = candidate_ratio - lhs[i] / rhs[i];
-      // collinear vectors must have equal ratio factor
-      if (fabs(diff) > ratio_diff_check_eps)
-        return {};
-    }
-  }
+  return CollinearityMult(lhs.data(), rhs.data(), lhs.size());
+}
 
-  return {candidate_ratio};
+/**
+ * Batched collinearity check: @lhs and @rhs hold pairs of @dim-sized
+ * vectors back to back, out[k] = CollinearityMult of k-th pair.
+ * @out storage is reused
+ */
+template <typename T, typename Alloc>
+std::vector<std::optional<double>> &CollinearityMultBatch(
+    std::vector<std::optional<double>> &out, const std::vector<T, Alloc> &lhs,
+    const std::vector<T, Alloc> &rhs, size_t dim) {
+  assert(lhs.size() == rhs.size() && dim > 0 && lhs.size() % dim == 0);
+  out.resize(lhs.size() / dim);
+  for (size_t k = 0; k < out.size(); k++)
+    out[k] = CollinearityMult(lhs.data() + k * dim, rhs.data() + k * dim, dim);
+  return out;
 }
 
 /**
  * Binary operator of collinearity check,
  * implementation is encapsulated in collinearity mult getter
  */
-template <typename T>
-bool operator||(const std::vector<T> &lhs, const std::vector<T> &rhs) {
+template <typename T, typename Alloc>
+bool operator||(const std::vector<T, Alloc> &lhs, const std::vector<T, Alloc> &rhs) {
   return CollinearityMult(lhs, rhs).has_value();
 }
 
@@ -148,8 +153,8 @@ bool operator||(const std::vector<T> &lhs, const std::vector<T> &rhs) {
  * true if collinear vectors have same direction,
  * false otherwise
  */
-template <typename T>
-bool operator&&(const std::vector<T> &lhs, const std::vector<T> &rhs) {
+template <typename T, typename Alloc>
+bool operator&&(const std::vector<T, Alloc> &lhs, const std::vector<T, Alloc> &rhs) {
   auto opt = CollinearityMult(lhs, rhs);
   return opt.has_value() && opt.value() > 0.;
 }
@@ -157,27 +162,100 @@ bool operator&&(const std::vector<T> &lhs, const std::vector<T> &rhs) {
 /**
  * Binary operator of bitwise |, implemented only for integer types
  */
-template <typename T>
-std::vector<T> operator|(const std::vector<T> &lhs, const std::vector<T> &rhs) {
-  static_assert(std::is_integral<T>::value, "Integral required.");
-  return VectorTransform(lhs, rhs, std::bit_or<>{});
+template <typename T, typename Alloc>
+std::vector<T, Alloc> operator|(const std::vector<T, Alloc> &lhs,
+                                const std::vector<T, Alloc> &rhs) {
+  std::vector<T, Alloc> out(lhs.get_allocator());
+  bitwise_or(out, lhs, rhs);
+  return out;
 }
 
 /**
  * Binary operator of bitwise &, implemented only for integer types
  */
-template <typename T>
-std::vector<T> operator&(const std::vector<T> &lhs, const std::vector<T> &rhs) {
-  static_assert(std::is_integral<T>::value, "Integral required.");
-  return VectorTransform(lhs, rhs, std::bit_and<>{});
+template <typename T, typename Alloc>
+std::vector<T, Alloc> operator&(const std::vector<T, Alloc> &lhs,
+                                const std::vector<T, Alloc> &rhs) {
+  std::vector<T, Alloc> out(lhs.get_allocator());
+  bitwise_and(out, lhs, rhs);
+  return out;
+}
+
+/**
+ * Write func(lhs[i], rhs[i]) into @out, its storage is reused when the
+ * capacity suffices. @out may be one of the operands
+ */
+template <typename T, typename A, typename U, typename B, typename V, typename C,
+          typename Functor>
+std::vector<T, A> &transform_into(std::vector<T, A> &out, const std::vector<U, B> &lhs,
+                                  const std::vector<V, C> &rhs, Functor func) {
+  assert(lhs.size() == rhs.size());
+  out.resize(lhs.size());
+  std::transform(cbegin(lhs), cend(lhs), cbegin(rhs), begin(out), func);
+  return out;
+}
+
+/**
+ * Write func(v[i]) into @out, its storage is reused when the capacity
+ * suffices. @out may be @v
+ */
+template <typename T, typename A, typename U, typename B, typename Functor>
+std::vector<T, A> &transform_into(std::vector<T, A> &out, const std::vector<U, B> &v,
+                                  Functor func) {
+  out.resize(v.size());
+  std::transform(cbegin(v), cend(v), begin(out), func);
+  return out;
+}
+
+/**
+ * Compound plus, lhs[i] += rhs[i], no allocation
+ */
+template <typename T, typename Alloc>
+std::vector<T, Alloc> &operator+=(std::vector<T, Alloc> &lhs, const std::vector<T, Alloc> &rhs) {
+  return transform_into(lhs, lhs, rhs, std::plus<>{});
+}
+
+/**
+ * Compound minus, lhs[i] -= rhs[i], no allocation
+ */
+template <typename T, typename Alloc>
+std::vector<T, Alloc> &operator-=(std::vector<T, Alloc> &lhs, const std::vector<T, Alloc> &rhs) {
+  return transform_into(lhs, lhs, rhs, std::minus<>{});
+}
+
+/**
+ * Compound multiplication by scalar, v[i] *= scalar, no allocation
+ */
+template <typename T, typename Alloc>
+std::vector<T, Alloc> &operator*=(std::vector<T, Alloc> &v,
+                                  const typename std::vector<T, Alloc>::value_type &scalar) {
+  for (auto &item : v)
+    item *= scalar;
+  return v;
+}
+
+/**
+ * Compound bitwise |, implemented only for integer types
+ */
+template <typename T, typename Alloc>
+std::vector<T, Alloc> &operator|=(std::vector<T, Alloc> &lhs, const std::vector<T, Alloc> &rhs) {
+  return bitwise_or(lhs, lhs, rhs);
+}
+
+/**
+ * Compound bitwise &, implemented only for integer types
+ */
+template <typename T, typename Alloc>
+std::vector<T, Alloc> &operator&=(std::vector<T, Alloc> &lhs, const std::vector<T, Alloc> &rhs) {
+  return bitwise_and(lhs, lhs, rhs);
 }
 
 /**
  * Input operator >>, first read number is a size of @v, other values are
  * vector's elements
  */
-template <typename T>
-std::istream& operator>>(std::istream &s, std::vector<T> &v) {
+template <typename T, typename Alloc>
+std::istream& operator>>(std::istream &s, std::vector<T, Alloc> &v) {
   size_t len;
   s >> len;
   v.resize(len);
@@ -189,22 +267,23 @@ std::istream& operator>>(std::istream &s, std::vector<T> &v) {
 
 /**
  * Output operator <<, copy all vector values into stream @s with space as
- * delimiter, output is ending with newline
+ * delimiter, output is ending with newline. The stream is not flushed,
+ * see TextWriter for bulk output
  */
-template <typename T>
-std::ostream& operator<<(std::ostream &s, const std::vector<T> &v) {
+template <typename T, typename Alloc>
+std::ostream& operator<<(std::ostream &s, const std::vector<T, Alloc> &v) {
   for (size_t i = 0; i < v.size(); i++) {
     s << v[i] << " ";
   }
-  s << std::endl;
+  s << '\n';
   return s;
 }
 
 /**
  * Reverse elements of @v
  */
-template <typename T>
-void reverse(std::vector<T> &v) {
+template <typename T, typename Alloc>
+void reverse(std::vector<T, Alloc> &v) {
   // impl of std::reverse(begin(v), end(v));
   auto first = v.begin(), last = v.end();
   while ((first != last) && (first != --last)) {
@@ -212,5 +291,155 @@ void reverse(std::vector<T> &v) {
   }
 }
 
-} // namespace task
+/**
+ * Span overloads of the operations above, for memory owned elsewhere.
+ * Operators producing a vector return a new std::vector, compound
+ * operators and transform_into write through the span in place.
+ * Operand spans may differ in constness, not in element type
+ */
+
+/**
+ * Write func(lhs[i], rhs[i]) into @out of the operands size,
+ * @out may view one of the operands
+ */
+template <typename T, typename U, typename V, typename Functor>
+Span<T> transform_into(Span<T> out, Span<U> lhs, Span<V> rhs, Functor func) {
+  assert(lhs.size() == rhs.size() && out.size() == lhs.size());
+  std::transform(lhs.begin(), lhs.end(), rhs.begin(), out.begin(), func);
+  return out;
+}
+
+/**
+ * Write func(v[i]) into @out of the same size, @out may view @v
+ */
+template <typename T, typename U, typename Functor>
+Span<T> transform_into(Span<T> out, Span<U> v, Functor func) {
+  assert(out.size() == v.size());
+  std::transform(v.begin(), v.end(), out.begin(), func);
+  return out;
+}
+
+template <typename L, typename R, typename T = detail::SpanValue<L, R>>
+std::vector<T> operator+(Span<L> lhs, Span<R> rhs) {
+  std::vector<T> out(lhs.size());
+  transform_into(Span<T>(out), lhs, rhs, std::plus<>{});
+  return out;
+}
+
+template <typename L, typename R, typename T = detail::SpanValue<L, R>>
+std::vector<T> operator-(Span<L> lhs, Span<R> rhs) {
+  std::vector<T> out(lhs.size());
+  transform_into(Span<T>(out), lhs, rhs, std::minus<>{});
+  return out;
+}
+
+template <typename T>
+std::vector<std::remove_cv_t<T>> operator+(Span<T> v) {
+  return v.toVector();
+}
+
+template <typename T>
+std::vector<std::remove_cv_t<T>> operator-(Span<T> v) {
+  using U = std::remove_cv_t<T>;
+  std::vector<U> out(v.size());
+  transform_into(Span<U>(out), v, [](const U &a) { return -a; });
+  return out;
+}
+
+template <typename L, typename R, typename T = detail::SpanValue<L, R>>
+double operator*(Span<L> lhs, Span<R> rhs) {
+  assert(lhs.size() == rhs.size());
+  if constexpr (std::is_arithmetic<T>::value) {
+    return static_cast<double>(simd::dot<T>(lhs.data(), rhs.data(), lhs.size()));
+  } else {
+    double res = 0.0;
+    for (size_t i = 0; i < lhs.size(); i++)
+      res += lhs[i] * rhs[i];
+    return res;
+  }
+}
+
+template <typename L, typename R, typename T = detail::SpanValue<L, R>>
+std::vector<T> operator%(Span<L> lhs, Span<R> rhs) {
+  assert(lhs.size() == 3 && rhs.size() == 3);
+  return {lhs[1] * rhs[2] - lhs[2] * rhs[1],
+          lhs[2] * rhs[0] - lhs[0] * rhs[2],
+          lhs[0] * rhs[1] - lhs[1] * rhs[0]};
+}
+
+template <typename L, typename R, typename T = detail::SpanValue<L, R>>
+std::optional<double> CollinearityMult(Span<L> lhs, Span<R> rhs) {
+  assert(lhs.size() == rhs.size());
+  return CollinearityMult<T>(lhs.data(), rhs.data(), lhs.size());
+}
+
+template <typename L, typename R, typename = detail::SpanValue<L, R>>
+bool operator||(Span<L> lhs, Span<R> rhs) {
+  return CollinearityMult(lhs, rhs).has_value();
+}
+
+template <typename L, typename R, typename = detail::SpanValue<L, R>>
+bool operator&&(Span<L> lhs, Span<R> rhs) {
+  auto opt = CollinearityMult(lhs, rhs);
+  return opt.has_value() && opt.value() > 0.;
+}
 
+template <typename L, typename R, typename T = detail::SpanValue<L, R>>
+std::vector<T> operator|(Span<L> lhs, Span<R> rhs) {
+  std::vector<T> out(lhs.size());
+  bitwise_or(Span<T>(out), lhs, rhs);
+  return out;
+}
+
+template <typename L, typename R, typename T = detail::SpanValue<L, R>>
+std::vector<T> operator&(Span<L> lhs, Span<R> rhs) {
+  std::vector<T> out(lhs.size());
+  bitwise_and(Span<T>(out), lhs, rhs);
+  return out;
+}
+
+template <typename T, typename R, typename = detail::SpanValue<T, R>>
+Span<T> operator+=(Span<T> lhs, Span<R> rhs) {
+  return transform_into(lhs, lhs, rhs, std::plus<>{});
+}
+
+template <typename T, typename R, typename = detail::SpanValue<T, R>>
+Span<T> operator-=(Span<T> lhs, Span<R> rhs) {
+  return transform_into(lhs, lhs, rhs, std::minus<>{});
+}
+
+template <typename T>
+Span<T> operator*=(Span<T> v, const typename Span<T>::value_type &scalar) {
+  for (auto &item : v)
+    item *= scalar;
+  return v;
+}
+
+template <typename T, typename R, typename = detail::SpanValue<T, R>>
+Span<T> operator|=(Span<T> lhs, Span<R> rhs) {
+  return bitwise_or(lhs, lhs, rhs);
+}
+
+template <typename T, typename R, typename = detail::SpanValue<T, R>>
+Span<T> operator&=(Span<T> lhs, Span<R> rhs) {
+  return bitwise_and(lhs, lhs, rhs);
+}
+
+template <typename T>
+std::ostream& operator<<(std::ostream &s, Span<T> v) {
+  for (size_t i = 0; i < v.size(); i++) {
+    s << v[i] << " ";
+  }
+  s << '\n';
+  return s;
+}
+
+template <typename T>
+void reverse(Span<T> v) {
+  auto first = v.begin(), last = v.end();
+  while ((first != last) && (first != --last)) {
+    std::iter_swap(first++, last);
+  }
+}
+
+} // namespace task
@@ -6,6 +6,7 @@
 #include <valarray>
 #include <sstream>
 #include <cmath>
+#include <limits>
 #include "src/vector_ops.h"
 
 
@@ -52,6 +53,20 @@ void RandomFillDouble(T& container, size_t count) {
 }
 
 
+template <class T>
+struct TaggedAllocator : std::allocator<T> {
+    template <class U>
+    struct rebind {
+        using other = TaggedAllocator<U>;
+    };
+
+    TaggedAllocator() = default;
+
+    template <class U>
+    TaggedAllocator(const TaggedAllocator<U>&) {}
+};
+
+
 void FailWithMsg(const std::string& msg, int line) {
     std::cerr << "Test failed!\n";
     std::cerr << "[Line " << line << "] "  << msg << std::endl;
@@ -137,6 +152,134 @@ int main() {
         ASSERT_TRUE_MSG(fabs(res - res2) < EPS, "Dot product")
     }
 
+    REPEAT(20)
+    {
+        // lazy expressions match eager operators
+        std::vector<double> vec, vec2, vec3;
+        RandomFillDouble(vec, 1000);
+        RandomFillDouble(vec2, vec.size());
+        RandomFillDouble(vec3, vec.size());
+
+        std::vector<double> eager = -(vec + vec2 - vec3);
+        std::vector<double> fused = -(lazy(vec) + vec2 - vec3);
+        ASSERT_EQUAL_MSG(fused, eager, "Lazy expression")
+        eager = vec3 - (vec + vec2);
+        fused = (vec3 - (+lazy(vec) + vec2)).eval();
+        ASSERT_EQUAL_MSG(fused, eager, "Lazy expression")
+        ASSERT_TRUE_MSG(fabs((lazy(vec) - vec2) * vec3 - (vec - vec2) * vec3) < EPS, "Lazy dot product")
+
+        eager = vec + vec2 - vec;
+        (lazy(vec) + vec2 - vec).evalTo(vec);
+        ASSERT_EQUAL_MSG(vec, eager, "Lazy evalTo aliasing")
+
+        std::vector<int> ivec, ivec2;
+        RandomFill(ivec, 100);
+        RandomFill(ivec2, ivec.size());
+        std::vector<int> ieager = (ivec | ivec2) & ivec;
+        std::vector<int> ifused = (lazy(ivec) | ivec2) & ivec;
+        ASSERT_EQUAL_MSG(ifused, ieager, "Lazy bitwise")
+    }
+
+    REPEAT(20)
+    {
+        // compound operators update in place
+        std::vector<double> vec, vec2;
+        RandomFillDouble(vec, 1000);
+        RandomFillDouble(vec2, vec.size());
+        const double *storage = vec.data();
+        const double mult = RandomDouble();
+
+        std::vector<double> expected = vec + vec2;
+        vec += vec2;
+        ASSERT_EQUAL_MSG(vec, expected, "Compound +=")
+        expected = vec - vec2;
+        vec -= vec2;
+        ASSERT_EQUAL_MSG(vec, expected, "Compound -=")
+        for (auto& item : expected)
+            item *= mult;
+        vec *= mult;
+        ASSERT_EQUAL_MSG(vec, expected, "Compound *=")
+
+        expected = vec + vec2 - vec2;
+        transform_into(vec, vec, vec2, [](double a, double b) { return a + b - b; });
+        ASSERT_EQUAL_MSG(vec, expected, "transform_into")
+        expected = -vec;
+        transform_into(vec, vec, [](double a) { return -a; });
+        ASSERT_EQUAL_MSG(vec, expected, "transform_into")
+        ASSERT_TRUE_MSG(vec.data() == storage, "Compound operators reuse storage")
+
+        std::vector<int> ivec, ivec2;
+        RandomFill(ivec, 100);
+        RandomFill(ivec2, ivec.size());
+        std::vector<int> iexpected = ivec | ivec2;
+        ivec |= ivec2;
+        ASSERT_EQUAL_MSG(ivec, iexpected, "Compound |=")
+        iexpected = ivec & ivec2;
+        ivec &= ivec2;
+        ASSERT_EQUAL_MSG(ivec, iexpected, "Compound &=")
+
+        // values small enough for the product to stay in int range
+        std::vector<int> ismall;
+        RandomFill(ismall, 100, 2000);
+        for (auto& item : ismall)
+            item -= 1000;
+        iexpected = ismall;
+        for (auto& item : iexpected)
+            item *= 3;
+        ismall *= 3;
+        ASSERT_EQUAL_MSG(ismall, iexpected, "Compound *= int")
+    }
+
+    REPEAT(20)
+    {
+        // BLAS-1 kernels against scalar loops
+        size_t n = RandomUInt(0, 100);
+        std::vector<double> x, y, z;
+        RandomFillDouble(x, n);
+        RandomFillDouble(y, n);
+        RandomFillDouble(z, n);
+        const double alpha = RandomDouble(), beta = RandomDouble();
+
+        std::vector<double> expected = y, out;
+        for (size_t i = 0; i < n; ++i)
+            expected[i] = alpha * x[i] + beta * y[i];
+        std::vector<double> res = y;
+        axpby(alpha, x, beta, res);
+        ASSERT_TRUE_MSG(std::equal(res.begin(), res.end(), expected.begin(),
+                        [](double a, double b) { return fabs(a - b) < EPS; }), "axpby")
+
+        res = y;
+        axpy(alpha, x, res);
+        scal(beta, res);
+        fmadd(out, x, y, z);
+        double norm = 0, sum = 0;
+        for (size_t i = 0; i < n; ++i) {
+            ASSERT_TRUE_MSG(fabs(res[i] - beta * (y[i] + alpha * x[i])) < EPS, "axpy, scal")
+            ASSERT_TRUE_MSG(fabs(out[i] - (x[i] * y[i] + z[i])) < EPS, "fmadd")
+            norm += x[i] * x[i];
+            sum += fabs(x[i]);
+        }
+        ASSERT_TRUE_MSG(fabs(norm2(x) - sqrt(norm)) < EPS && fabs(asum(x) - sum) < EPS, "norm2, asum")
+        ASSERT_TRUE_MSG(fma(2., 3., 1.) == 7., "scalar fma is not hidden")
+
+        lerp_into(x, x, y, 0.25);
+        lerp_into(out, x, y, 1.);
+        ASSERT_TRUE_MSG(std::equal(out.begin(), out.end(), y.begin(),
+                        [](double a, double b) { return fabs(a - b) < EPS; }), "lerp_into")
+
+        std::vector<float> fx(z.begin(), z.end());
+        double fsum = 0;
+        for (float item : fx)
+            fsum += fabs(double(item));
+        ASSERT_TRUE_MSG(fabs(asum(fx) - fsum) < EPS, "asum float")
+        std::vector<int> ix{-3, 4, std::numeric_limits<int>::min(), 7, -1, 2, 5, -6, 8, 0};
+        std::vector<int> iy(ix.size(), 1);
+        ASSERT_TRUE_MSG(asum(ix) == 36 + 2147483648ll, "asum int widening")
+        axpy(2, iy, iy);
+        scal(-2, iy);
+        ASSERT_TRUE_MSG(iy == std::vector<int>(ix.size(), -6), "axpy, scal int")
+    }
+
     REPEAT(100)
     {
         std::vector<int> vec, vec2;
@@ -159,6 +302,40 @@ int main() {
         ASSERT_EQUAL_MSG(vec, valarr, "Bitwise AND")
     }
 
+    REPEAT(20)
+    {
+        // every supported isa agrees with a long double reference
+        size_t n = RandomUInt(0, 100);
+        std::vector<double> vec, vec2;
+        RandomFillDouble(vec, n);
+        RandomFillDouble(vec2, n);
+        std::vector<float> fvec(vec.begin(), vec.end()), fvec2(vec2.begin(), vec2.end());
+        std::vector<int> ivec, ivec2;
+        for (size_t i = 0; i < n; ++i) {
+            ivec.push_back(int(RandomUInt(0, 4000000000u) - 2000000000));
+            ivec2.push_back(int(RandomUInt(0, 4000000000u) - 2000000000));
+        }
+
+        long double ref = 0, fref = 0;
+        int64_t iref = 0;
+        for (size_t i = 0; i < n; ++i) {
+            ref += (long double)vec[i] * vec2[i];
+            fref += (long double)fvec[i] * fvec2[i];
+            iref += int64_t(ivec[i]) * (ivec2[i] % 4);
+            ivec2[i] %= 4;
+        }
+
+        for (auto isa : {simd::Isa::Generic, simd::Isa::Sse2, simd::Isa::Avx2}) {
+            if (!simd::supported(isa))
+                continue;
+            ASSERT_TRUE_MSG(fabs(simd::dot(vec.data(), vec2.data(), n, isa) - ref) < EPS, "SIMD dot double")
+            ASSERT_TRUE_MSG(fabs(simd::dot(fvec.data(), fvec2.data(), n, isa) - fref) < EPS, "SIMD dot float")
+            ASSERT_TRUE_MSG(simd::dot(ivec.data(), ivec2.data(), n, isa) == iref, "SIMD dot int widening")
+        }
+        ASSERT_TRUE_MSG(fabs(vec * vec2 - ref) < EPS, "Dot product")
+        ASSERT_TRUE_MSG(ivec * ivec2 == double(iref), "Dot product int")
+    }
+
     REPEAT(100)
     {
         std::vector<double> vec, vec2;
@@ -202,6 +379,522 @@ int main() {
         ASSERT_TRUE_MSG(!(vec && vec2), "Codirectionality operator")
     }
 
+    {
+        // parallel overloads: fixed chunking gives identical results for any thread count
+        std::vector<double> vec, vec2;
+        RandomFillDouble(vec, 100000 + RandomUInt(0, 1000));
+        RandomFillDouble(vec2, vec.size());
+        std::vector<int> ivec, ivec2;
+        RandomFill(ivec, vec.size(), 1000);
+        RandomFill(ivec2, vec.size(), 1000);
+
+        execution::ParallelPolicy policy;
+        policy.threads = 1;
+        const double single = dot(policy, vec, vec2);
+        const int64_t isingle = dot(policy, ivec, ivec2);
+        ASSERT_TRUE_MSG(fabs(single - vec * vec2) < 1e-6 && double(isingle) == ivec * ivec2, "Parallel dot")
+        for (size_t threads : {0, 2, 3, 8}) {
+            policy.threads = threads;
+            policy.threshold = threads;
+            ASSERT_TRUE_MSG(dot(policy, vec, vec2) == single && dot(policy, ivec, ivec2) == isingle, "Parallel dot determinism")
+
+            std::vector<double> sum = VectorTransform(policy, vec, vec2, std::plus<>{});
+            std::vector<double> expected = vec + vec2;
+            ASSERT_EQUAL_MSG(sum, expected, "Parallel transform")
+            std::vector<int> ior = ivec;
+            transform_into(policy, ior, ior, ivec2, std::bit_or<>{});
+            std::vector<int> iexpected = ivec | ivec2;
+            ASSERT_EQUAL_MSG(ior, iexpected, "Parallel transform_into")
+        }
+        ASSERT_TRUE_MSG(dot(execution::par, std::vector<double>{}, std::vector<double>{}) == 0., "Parallel dot")
+
+        // parallel calls from inside a parallel task run inline instead of waiting for the pool
+        policy.threads = 0;
+        policy.threshold = 0;
+        std::vector<double> nested(4);
+        detail::ThreadPool::instance().run(nested.size(), 0, [&](size_t task) { nested[task] = dot(policy, vec, vec2); });
+        ASSERT_TRUE_MSG(std::all_of(nested.begin(), nested.end(), [&](double d) { return d == single; }), "Nested parallel dot")
+    }
+
+    {
+        // zero patterns, pivots and batches of collinearity checks
+        using V = std::vector<double>;
+        ASSERT_TRUE_MSG(!(V{0., 1.} || V{5., 1.}), "Collinearity zero pattern")
+        ASSERT_TRUE_MSG(!(V{1., 0.} || V{0., 1.}), "Collinearity zero pattern")
+        ASSERT_TRUE_MSG((V{0., 0.} || V{0., 1.}) && !(V{0., 0.} && V{0., 1.}), "Collinearity zero vector")
+        ASSERT_TRUE_MSG((V{0., 2., 0., -4.} && V{0., 1., 0., -2.}), "Codirectionality operator")
+        ASSERT_TRUE_MSG(*CollinearityMult(V{0., -3., 6.}, V{0., 1., -2.}) == -3., "Collinearity multiplier")
+        ASSERT_TRUE_MSG((std::vector<int>{2, 4, 6} || std::vector<int>{1, 2, 3}), "Collinearity int")
+        // squared norms and elements up to 1e-64 count as zero, denormals included
+        ASSERT_TRUE_MSG((V{1e-40, 0.} || V{0., 1.}) && *CollinearityMult(V{1e-40, 0.}, V{0., 1.}) == 0.,
+                        "Collinearity tiny vector")
+        ASSERT_TRUE_MSG((V{0., 1.} || V{0., 1e-310}) && !(V{0., 1e-310} && V{0., 1.}), "Collinearity denormal vector")
+        ASSERT_TRUE_MSG(*CollinearityMult(V{1., 2., 1e-70}, V{2., 4., 0.}) == 0.5, "Collinearity tiny element")
+        V tiny_long(67, 1e-40), unit_long(67, 0.);
+        unit_long[66] = 1.;
+        ASSERT_TRUE_MSG((tiny_long || unit_long) && *CollinearityMult(tiny_long, unit_long) == 0., "Collinearity tiny vector")
+
+        std::vector<double> lhs, rhs;
+        std::vector<std::optional<double>> mults;
+        for (size_t k = 0; k < 100; ++k) {
+            double mult = RandomDouble();
+            for (size_t i = 0; i < 3; ++i) {
+                rhs.push_back(RandomDouble());
+                lhs.push_back(rhs.back() * (k % 2 ? mult : RandomDouble()));
+            }
+        }
+        CollinearityMultBatch(mults, lhs, rhs, 3);
+        ASSERT_TRUE_MSG(mults.size() == 100, "Batched collinearity")
+        for (size_t k = 0; k < mults.size(); ++k) {
+            V l(lhs.begin() + 3 * k, lhs.begin() + 3 * k + 3), r(rhs.begin() + 3 * k, rhs.begin() + 3 * k + 3);
+            ASSERT_TRUE_MSG(mults[k] == CollinearityMult(l, r) && (k % 2 == 0 || mults[k]), "Batched collinearity")
+        }
+    }
+
+    {
+        // fixed-size Vec: compile time evaluation and agreement with std::vector operators
+        constexpr Vec3d x{{1., 0., 0.}}, y{{0., 1., 0.}};
+        static_assert(x % y == Vec3d{{0., 0., 1.}}, "Vec cross product");
+        static_assert(x * y == 0. && (x + y) * (x - y) == 0., "Vec dot product");
+        static_assert((2. * x || x) && (2. * x && x) && !(-x && x) && !(x || y), "Vec collinearity");
+        static_assert((Vec3i{{1, 2, 4}} | Vec3i{{2, 2, 0}}) == Vec3i{{3, 2, 4}}, "Vec bitwise or");
+
+        REPEAT(100) {
+            std::vector<double> a, b;
+            RandomFillDouble(a, 3);
+            RandomFillDouble(b, 3);
+            const Vec3d va = Vec3d::from(a), vb = Vec3d::from(b);
+
+            std::vector<double> cross = a % b, vcross = (va % vb).toVector();
+            ASSERT_EQUAL_MSG(cross, vcross, "Vec cross product")
+            ASSERT_TRUE_MSG(fabs(va * vb - a * b) < EPS, "Vec dot product")
+            std::vector<double> sum = a + b, vsum = (va + vb).toVector();
+            ASSERT_EQUAL_MSG(sum, vsum, "Vec plus")
+
+            const double mult = RandomDouble();
+            std::vector<double> scaled = a;
+            for (auto &value : scaled)
+                value *= mult;
+            const Vec3d vscaled = Vec3d::from(scaled);
+            ASSERT_TRUE_MSG(CollinearityMult(vscaled, va) == CollinearityMult(scaled, a), "Vec collinearity")
+            ASSERT_TRUE_MSG((vscaled && va) == (scaled && a) && (va || vb) == (a || b), "Vec collinearity")
+
+            // tiny elements and vectors follow the std::vector rule
+            const Vec3d tiny_elem{{1e-70, 1., 2.}}, doubled{{0., 2., 4.}}, tiny_vec{{1e-40, 0., 0.}}, unit_y{{0., 1., 0.}};
+            ASSERT_TRUE_MSG(CollinearityMult(tiny_elem, doubled) == CollinearityMult(tiny_elem.toVector(), doubled.toVector()) &&
+                            *CollinearityMult(tiny_elem, doubled) == 0.5, "Vec collinearity tiny element")
+            ASSERT_TRUE_MSG((tiny_vec || unit_y) && !(tiny_vec && unit_y) && (tiny_vec || unit_y) == (tiny_vec.toVector() || unit_y.toVector()),
+                            "Vec collinearity tiny vector")
+
+            Vec3d acc = va;
+            acc += vb;
+            acc -= vb;
+            acc *= 2.;
+            ASSERT_TRUE_MSG(acc == 2. * va || (acc - 2. * va) * (acc - 2. * va) < EPS, "Vec compound operators")
+        }
+
+        std::stringstream stream;
+        stream << Vec<2, int>{{1, 2}};
+        ASSERT_TRUE_MSG(stream.str() == "1 2 \n", "Vec output operator")
+    }
+
+    REPEAT(20)
+    {
+        // SoA batch kernels against per-element std::vector operators
+        std::vector<std::vector<double>> as, bs;
+        for (size_t i = 0, n = RandomUInt(0, 50); i < n; ++i) {
+            std::vector<double> a, b;
+            RandomFillDouble(a, 3);
+            RandomFillDouble(b, 3);
+            as.push_back(a);
+            bs.push_back(i % 3 == 0 ? std::vector<double>{2. * a[0], 2. * a[1], 2. * a[2]} : b);
+            if (i % 7 == 0)
+                as.back().assign(3, 0.);
+        }
+        const Vec3Array<double> a(as), b(bs);
+        std::vector<std::vector<double>> round_trip = a.toVectors();
+        ASSERT_TRUE_MSG(round_trip == as, "SoA conversion")
+
+        Vec3Array<double> crosses;
+        cross(crosses, a, b);
+        std::vector<double> dots;
+        dot(dots, a, b);
+        std::vector<char> col, codir;
+        collinear(col, a, b);
+        codirected(codir, a, b);
+        Vec3Array<double> unit = a;
+        normalize(unit);
+        for (size_t i = 0; i < as.size(); ++i) {
+            std::vector<double> expected = as[i] % bs[i], actual = crosses[i].toVector();
+            ASSERT_TRUE_MSG(fabs(norm2(expected - actual)) < EPS, "SoA cross product")
+            ASSERT_TRUE_MSG(fabs(dots[i] - as[i] * bs[i]) < EPS, "SoA dot product")
+            ASSERT_TRUE_MSG(bool(col[i]) == (as[i] || bs[i]), "SoA collinearity")
+            ASSERT_TRUE_MSG(bool(codir[i]) == (as[i] && bs[i]), "SoA codirectionality")
+            const double len = norm2(as[i]);
+            ASSERT_TRUE_MSG(fabs(norm2(unit[i].toVector()) - (len > 0 ? 1. : 0.)) < EPS, "SoA normalize")
+        }
+
+        cross(crosses, a, a);
+        ASSERT_TRUE_MSG(std::all_of(crosses.x().begin(), crosses.x().end(), [](double v) { return fabs(v) < EPS; }), "SoA self cross")
+
+        Vec3Array<float> fa(as.size(), Vec3f{{1.f, 2.f, 2.f}});
+        normalize(fa);
+        ASSERT_TRUE_MSG(std::all_of(fa.y().begin(), fa.y().end(), [](float v) { return fabs(v - 2.f / 3.f) < 1e-6; }), "SoA float normalize")
+    }
+
+    {
+        // zero and tiny vectors in SoA kernels: collinear with anything, codirected with nothing
+        const std::vector<std::vector<double>> zs{{0., 0., 0.}, {1e-40, 0., 0.}, {0., 1e-310, 0.}, {0., 0., 0.}, {1e-40, 0., 0.}};
+        const std::vector<std::vector<double>> ws{{1., 2., 3.}, {0., 1., 0.}, {1., 0., 0.}, {0., 0., 0.}, {1., 0., 0.}};
+        std::vector<char> col, codir;
+        collinear(col, Vec3Array<double>(zs), Vec3Array<double>(ws));
+        codirected(codir, Vec3Array<double>(zs), Vec3Array<double>(ws));
+        for (size_t i = 0; i < zs.size(); ++i) {
+            ASSERT_TRUE_MSG(col[i] && (zs[i] || ws[i]), "SoA zero vector collinearity")
+            ASSERT_TRUE_MSG(!codir[i] && !(zs[i] && ws[i]), "SoA zero vector codirectionality")
+        }
+        collinear(col, Vec3Array<double>(ws), Vec3Array<double>(zs));
+        codirected(codir, Vec3Array<double>(ws), Vec3Array<double>(zs));
+        ASSERT_TRUE_MSG(std::all_of(col.begin(), col.end(), [](char c) { return c; }) &&
+                        std::none_of(codir.begin(), codir.end(), [](char c) { return c; }), "SoA zero vector symmetry")
+
+        // the ratio tolerance of the scalar operators near its boundary
+        const std::vector<std::vector<double>> ls{{1., 1e-3, 0.}, {1., 1e-3, 0.}, {0., 3., 1.}, {0., 3., 1.}, {-1., 2., 0.}, {1e-70, 1., 2.}};
+        const std::vector<std::vector<double>> rs{{1., 1e-3 + 1e-8, 0.}, {1., 1e-3 + 1e-14, 0.}, {0., 6., 2. + 1e-6}, {0., 6., 2. + 1e-8}, {2., -4., 0.}, {0., 2., 4.}};
+        collinear(col, Vec3Array<double>(ls), Vec3Array<double>(rs));
+        codirected(codir, Vec3Array<double>(ls), Vec3Array<double>(rs));
+        const std::vector<char> expected_col{0, 1, 0, 1, 1, 1}, expected_codir{0, 1, 0, 1, 0, 1};
+        for (size_t i = 0; i < ls.size(); ++i) {
+            ASSERT_TRUE_MSG(col[i] == expected_col[i] && bool(col[i]) == (ls[i] || rs[i]), "SoA collinearity tolerance")
+            ASSERT_TRUE_MSG(codir[i] == expected_codir[i] && bool(codir[i]) == (ls[i] && rs[i]), "SoA codirectionality tolerance")
+        }
+    }
+
+    REPEAT(20)
+    {
+        // bitwise kernels and packed bit vectors against element-wise references
+        std::vector<uint16_t> a, b;
+        RandomFill(a, RandomUInt(0, 300), 65535);
+        RandomFill(b, a.size(), 65535);
+        std::vector<uint16_t> res, expected(a.size());
+        bitwise_xor(res, a, b);
+        std::transform(a.begin(), a.end(), b.begin(), expected.begin(), std::bit_xor<>{});
+        ASSERT_EQUAL_MSG(res, expected, "Bitwise xor")
+        bitwise_andnot(res, a, b);
+        std::transform(a.begin(), a.end(), b.begin(), expected.begin(), [](uint16_t x, uint16_t y) { return uint16_t(x & ~y); });
+        ASSERT_EQUAL_MSG(res, expected, "Bitwise andnot")
+
+        std::vector<char> ma, mb;
+        RandomFill(ma, a.size(), 1);
+        RandomFill(mb, a.size(), 1);
+        const BitVector ba(ma), bb(mb);
+        ASSERT_TRUE_MSG(ba.size() == ma.size() && ba.toMask() == ma, "BitVector packing")
+        ASSERT_TRUE_MSG(ba.count() == size_t(std::count(ma.begin(), ma.end(), 1)), "BitVector count")
+
+        const BitVector bor = ba | bb, band = ba & bb, bxor = ba ^ bb, bnot = andNot(ba, bb), inv = ~ba;
+        for (size_t i = 0; i < ma.size(); ++i) {
+            ASSERT_TRUE_MSG(bor[i] == (ma[i] || mb[i]) && band[i] == (ma[i] && mb[i]), "BitVector or / and")
+            ASSERT_TRUE_MSG(bxor[i] == (ma[i] != mb[i]) && bnot[i] == (ma[i] && !mb[i]), "BitVector xor / andnot")
+            ASSERT_TRUE_MSG(inv[i] == !ma[i], "BitVector complement")
+        }
+        ASSERT_TRUE_MSG(inv.count() == ma.size() - ba.count(), "BitVector complement tail")
+        ASSERT_TRUE_MSG(ba.any() == (ba.count() > 0) && ba.all() == (ba.count() == ba.size()), "BitVector any / all")
+        ASSERT_TRUE_MSG((ba | inv).all() && (ba & inv).none() && BitVector(ma.size(), true).all(), "BitVector any / all")
+
+        BitVector grown;
+        for (char m : ma)
+            grown.push_back(m);
+        ASSERT_TRUE_MSG(grown == ba, "BitVector push_back")
+    }
+
+    REPEAT(20)
+    {
+        // to_chars text and binary records read back exactly
+        std::vector<std::vector<double>> vecs(RandomUInt(1, 20));
+        std::vector<std::vector<int>> ivecs(vecs.size());
+        for (size_t i = 0; i < vecs.size(); ++i) {
+            RandomFillDouble(vecs[i], RandomUInt(0, 30));
+            RandomFill(ivecs[i], RandomUInt(0, 30), 1000);
+        }
+
+        std::stringstream stream;
+        {
+            TextWriter writer(stream, 64);
+            for (const auto &v : vecs)
+                writer << v;
+        }
+        std::string text;
+        for (const auto &v : vecs) {
+            text += std::to_string(v.size()) + ' ';
+            formatTo(text, v);
+        }
+        const char *pos = text.data(), *last = text.data() + text.size();
+        for (const auto &v : vecs) {
+            std::vector<double> read;
+            pos = parseText(pos, last, read);
+            ASSERT_TRUE_MSG(pos && read == v, "Text round trip")
+        }
+        std::vector<double> read;
+        const std::string malformed = "3 1.5 x";
+        ASSERT_TRUE_MSG(!parseText(pos, last, read) && !parseText(malformed.data(), malformed.data() + malformed.size(), read), "Text parse error")
+        text = stream.str();
+        ASSERT_TRUE_MSG(std::count(text.begin(), text.end(), '\n') == std::ptrdiff_t(vecs.size()), "TextWriter output")
+
+        std::string binary;
+        std::stringstream binary_stream;
+        for (size_t i = 0; i < vecs.size(); ++i) {
+            appendBinary(binary, vecs[i]);
+            appendBinary(binary, ivecs[i]);
+            writeBinary(binary_stream, vecs[i]);
+            writeBinary(binary_stream, ivecs[i]);
+        }
+        ASSERT_TRUE_MSG(binary_stream.str() == binary && binary.size() % 8 == 0, "Binary stream output")
+
+        std::vector<uint64_t> mapped(binary.size() / 8);
+        std::memcpy(mapped.data(), binary.data(), binary.size());
+        pos = reinterpret_cast<const char *>(mapped.data());
+        last = pos + binary.size();
+        for (size_t i = 0; i < vecs.size(); ++i) {
+            VectorView<double> view;
+            pos = viewBinary(pos, last, view);
+            ASSERT_TRUE_MSG(pos && view.toVector() == vecs[i], "Binary view")
+            std::vector<int> ivec;
+            pos = readBinary(pos, last, ivec);
+            ASSERT_TRUE_MSG(pos && ivec == ivecs[i], "Binary read")
+        }
+        ASSERT_TRUE_MSG(pos == last && !readBinary(pos, last, read), "Binary end of data")
+    }
+
+    REPEAT(20)
+    {
+        // custom allocators and spans over foreign storage match std::vector results
+        std::vector<double> a, b;
+        RandomFillDouble(a, 3);
+        RandomFillDouble(b, 3);
+        using Tagged = std::vector<double, TaggedAllocator<double>>;
+        const Tagged ta(a.begin(), a.end()), tb(b.begin(), b.end());
+        std::vector<double> sum = a + b, cross = a % b, neg = -a;
+        Tagged tsum = ta + tb, tcross = ta % tb, tneg = -ta;
+        ASSERT_EQUAL_MSG(tsum, sum, "Allocator plus")
+        ASSERT_EQUAL_MSG(tcross, cross, "Allocator cross product")
+        ASSERT_EQUAL_MSG(tneg, neg, "Allocator unary minus")
+        ASSERT_TRUE_MSG(ta * tb == a * b && (ta || tb) == (a || b), "Allocator dot / collinearity")
+
+        // lazy expressions accept vectors of any allocator as operands
+        Tagged tlazy = lazy(ta) + tb;
+        std::vector<double> lazy_mixed = (-lazy(ta) + b).eval(), mixed = b - a;
+        ASSERT_EQUAL_MSG(tlazy, sum, "Allocator lazy expression")
+        ASSERT_EQUAL_MSG(lazy_mixed, mixed, "Allocator lazy expression")
+        (lazy(tb) - ta).evalTo(tlazy);
+        ASSERT_EQUAL_MSG(tlazy, mixed, "Allocator lazy evalTo")
+        ASSERT_TRUE_MSG(fabs((lazy(a) + tb) * ta - (sum * a)) < EPS, "Allocator lazy dot product")
+
+        // parallel overloads take any allocator and spans
+        execution::ParallelPolicy all_parallel;
+        all_parallel.threshold = 0;
+        Tagged tpar = VectorTransform(all_parallel, ta, tb, std::plus<>{}), tpar_into;
+        transform_into(all_parallel, tpar_into, ta, b, std::minus<>{});
+        ASSERT_EQUAL_MSG(tpar, sum, "Allocator parallel transform")
+        std::vector<double> diff = a - b;
+        ASSERT_EQUAL_MSG(tpar_into, diff, "Allocator parallel transform_into")
+        const double tpar_dot = dot(all_parallel, ta, tb), span_par_dot = dot(all_parallel, Span(a), Span<const double>(b));
+        ASSERT_TRUE_MSG(tpar_dot == a * b && span_par_dot == a * b, "Allocator / Span parallel dot")
+
+        double rows[4][3];
+        for (size_t i = 0; i < 3; ++i) {
+            rows[0][i] = a[i];
+            rows[1][i] = b[i];
+            rows[2][i] = 2. * a[i];
+            rows[3][i] = 0.;
+        }
+        const Span<const double> ra(rows[0]), rb(rows[1]);
+        std::vector<double> ssum = ra + rb, scross = ra % rb, sneg = -ra;
+        ASSERT_EQUAL_MSG(ssum, sum, "Span plus")
+        ASSERT_EQUAL_MSG(scross, cross, "Span cross product")
+        ASSERT_EQUAL_MSG(sneg, neg, "Span unary minus")
+        ASSERT_TRUE_MSG(ra * rb == a * b && (Span<double>(rows[2]) && ra) && norm2(ra) == norm2(a), "Span dot / collinearity")
+
+        Span<double> acc(rows[3]);
+        acc += ra;
+        acc -= Span<double>(rows[1]);
+        acc *= 2.;
+        axpy(1., rb, acc);
+        std::vector<double> expected = (a - b) + (a - b), tail(acc.begin(), acc.end());
+        axpy(1., b, expected);
+        ASSERT_EQUAL_MSG(tail, expected, "Span compound operators")
+
+        std::vector<int> flags;
+        RandomFill(flags, 16, 255);
+        Span<int> low = Span(flags).first(8), high = Span(flags).last(8);
+        std::vector<int> ior = low | high, iand = low & high;
+        low |= high;
+        ASSERT_EQUAL_MSG(ior, low, "Span bitwise or")
+        ASSERT_TRUE_MSG(iand.size() == 8 && Span(flags).subspan(4, 4).size() == 4, "Span bitwise and")
+    }
+
+    REPEAT(20)
+    {
+        // reductions against long double references, exact for integers
+        std::vector<double> vec;
+        RandomFillDouble(vec, RandomUInt(1, 3000));
+        std::vector<float> fvec(vec.begin(), vec.end());
+        std::vector<int> ivec;
+        RandomFill(ivec, vec.size(), 1000000);
+
+        long double ref = 0, ref_sq = 0, fref = 0;
+        for (size_t i = 0; i < vec.size(); ++i) {
+            ref += vec[i];
+            fref += fvec[i];
+        }
+        const long double ref_mean = ref / vec.size();
+        for (double v : vec)
+            ref_sq += (v - ref_mean) * (v - ref_mean);
+        ASSERT_TRUE_MSG(fabs(sum(vec) - double(ref)) < 1e-12 && fabs(sum(fvec) - double(fref)) < 1e-9, "Compensated sum")
+        ASSERT_TRUE_MSG(sum(ivec) == std::accumulate(ivec.begin(), ivec.end(), int64_t(0)), "Integer sum")
+
+        const auto [lo, hi] = std::minmax_element(vec.begin(), vec.end());
+        ASSERT_TRUE_MSG(minimum(vec) == *lo && maximum(vec) == *hi, "Minimum / maximum")
+        ASSERT_TRUE_MSG(argmin(vec) == size_t(lo - vec.begin()) && argmax(vec) == size_t(hi - vec.begin()), "Argmin / argmax")
+        ASSERT_TRUE_MSG(argmax(ivec) == size_t(std::max_element(ivec.begin(), ivec.end()) - ivec.begin()), "Integer argmax")
+        ASSERT_TRUE_MSG(normInf(vec) == std::max(-*lo, *hi) && fabs(norm1(vec) - double(asum(vec))) < EPS, "Norms")
+
+        const Moments m = moments(vec);
+        ASSERT_TRUE_MSG(m.count == vec.size() && fabs(m.mean - double(ref_mean)) < 1e-12, "Moments mean")
+        ASSERT_TRUE_MSG(fabs(m.variance() - double(ref_sq / vec.size())) < 1e-9, "Moments variance")
+
+        const size_t cols = RandomUInt(1, 300);
+        std::vector<int> matrix;
+        RandomFill(matrix, cols * RandomUInt(1, 20), 1000);
+        std::vector<int64_t> col_sums;
+        columnSums(col_sums, matrix, cols);
+        for (size_t j = 0; j < cols; ++j) {
+            int64_t expected = 0;
+            for (size_t r = 0; r < matrix.size() / cols; ++r)
+                expected += matrix[r * cols + j];
+            ASSERT_TRUE_MSG(col_sums[j] == expected, "Column sums")
+        }
+    }
+
+    {
+        // compensation keeps small terms next to large ones
+        std::vector<double> vec(100001, 1e-8);
+        vec[0] = 1e8;
+        ASSERT_TRUE_MSG(sum(vec) == 1e8 + 1e-3, "Compensated sum")
+        std::vector<double> col_sums;
+        columnSums(col_sums, vec, 1);
+        ASSERT_TRUE_MSG(col_sums[0] == 1e8 + 1e-3 && moments(std::vector<double>{}).count == 0, "Compensated column sums")
+    }
+
+    REPEAT(20)
+    {
+        // sparse vectors against their dense equivalents
+        const size_t dim = RandomUInt(1, 5000);
+        std::vector<double> a(dim), b(dim), dense;
+        for (size_t i = 0; i < dim; ++i) {
+            if (RandomUInt(20) == 0)
+                a[i] = RandomDouble();
+            if (RandomUInt(_iter % 2 ? 2 : 500) == 0)
+                b[i] = RandomDouble();
+        }
+        // at least one nonzero, so sa is never the zero vector
+        a[RandomUInt(dim - 1)] = 1. + fabs(RandomDouble());
+        RandomFillDouble(dense, dim);
+        const SparseVector<double> sa(a), sb(b);
+        ASSERT_TRUE_MSG(sa.toDense() == a && sa.nnz() == dim - std::count(a.begin(), a.end(), 0.), "Sparse conversion")
+        ASSERT_TRUE_MSG(fabs(sa * dense - a * dense) < 1e-9 && fabs(dense * sb - b * dense) < 1e-9, "Sparse-dense dot")
+        ASSERT_TRUE_MSG(fabs(sa * sb - a * b) < 1e-9 && fabs(sb * sa - a * b) < 1e-9, "Sparse-sparse dot")
+
+        std::vector<float> fa(a.begin(), a.end()), fdense(dense.begin(), dense.end());
+        ASSERT_TRUE_MSG(fabs(SparseVector<float>(fa) * fdense - fa * fdense) < 1e-6, "Sparse-dense float dot")
+
+        std::vector<double> sum = a + b, diff = a - b, sparse_sum = (sa + sb).toDense(), sparse_diff = (sa - sb).toDense();
+        ASSERT_EQUAL_MSG(sparse_sum, sum, "Sparse plus")
+        ASSERT_EQUAL_MSG(sparse_diff, diff, "Sparse minus")
+        ASSERT_TRUE_MSG((sa - sa).nnz() == 0 && (sa * 0.).nnz() == 0, "Sparse cancellation")
+
+        std::vector<double> y = dense, expected = dense;
+        axpy(2., sa, y);
+        axpy(2., a, expected);
+        ASSERT_EQUAL_MSG(y, expected, "Sparse axpy")
+
+        const SparseVector<double> scaled = sa * -3.;
+        ASSERT_TRUE_MSG((scaled || sa) && !(scaled && sa) && (sa && sa), "Sparse collinearity")
+        ASSERT_TRUE_MSG((sa || sb) == (a || b) && (SparseVector<double>(dim) || sa), "Sparse collinearity")
+        ASSERT_TRUE_MSG(sa[dim - 1] == a[dim - 1] && sa[0] == a[0], "Sparse element access")
+
+        // zero vector is collinear with anything and codirected with nothing, tiny values count as zero
+        const SparseVector<double> zero(dim);
+        std::vector<double> tiny(dim);
+        tiny[RandomUInt(dim - 1)] = 1e-40;
+        const SparseVector<double> stiny(tiny);
+        const std::optional<double> zero_mult = CollinearityMult(zero, sa);
+        ASSERT_TRUE_MSG(zero_mult && *zero_mult == 0. && (zero || zero) && !(zero && zero) && !(sa && zero), "Sparse zero vector")
+        ASSERT_TRUE_MSG((stiny || sa) && (sa || stiny) && !(stiny && sa) && (stiny || sa) == (tiny || a), "Sparse tiny vector")
+
+        // stored values up to 1e-64 are zeros for the pattern as in the dense rule
+        const std::vector<double> tiny_elem{1., 1e-70, 2.}, doubled{2., 0., 4.};
+        const SparseVector<double> stiny_elem(tiny_elem), sdoubled(doubled);
+        const std::optional<double> tiny_elem_mult = CollinearityMult(stiny_elem, sdoubled);
+        ASSERT_TRUE_MSG(tiny_elem_mult && *tiny_elem_mult == 0.5 && tiny_elem_mult == CollinearityMult(tiny_elem, doubled) &&
+                        (sdoubled && stiny_elem) && !(SparseVector<double>(std::vector<double>{1., 1e-9, 2.}) || sdoubled),
+                        "Sparse collinearity tiny element")
+    }
+
+    REPEAT(50)
+    {
+        // small integer kernels against 64-bit reference, extremes included
+        const size_t n = RandomUInt(0, 300);
+        std::vector<int8_t> a8(n), b8(n);
+        std::vector<int16_t> a16(n), b16(n);
+        int64_t ref8 = 0, ref16 = 0;
+        for (size_t i = 0; i < n; ++i) {
+            a8[i] = int8_t(_iter % 5 ? RandomUInt(256) : 128);
+            b8[i] = int8_t(_iter % 5 ? RandomUInt(256) : 128);
+            a16[i] = int16_t(_iter % 5 ? RandomUInt(65536) : 32768);
+            b16[i] = int16_t(_iter % 5 ? RandomUInt(65536) : 32768);
+            ref8 += int64_t(a8[i]) * b8[i];
+            ref16 += int64_t(a16[i]) * b16[i];
+        }
+        for (auto isa : {simd::Isa::Generic, simd::Isa::Sse2, simd::Isa::Avx2}) {
+            if (!simd::supported(isa))
+                continue;
+            ASSERT_TRUE_MSG(simd::dot(a8.data(), b8.data(), n, isa) == ref8, "SIMD dot int8")
+            ASSERT_TRUE_MSG(simd::dot(a16.data(), b16.data(), n, isa) == ref16, "SIMD dot int16")
+        }
+        ASSERT_TRUE_MSG(a8 * b8 == double(ref8) && a16 * b16 == double(ref16), "Dot product small int")
+
+        std::vector<double> x, y, restored;
+        RandomFillDouble(x, n);
+        RandomFillDouble(y, n);
+        const Quantized<int8_t> qx8 = quantize<int8_t>(x), qy8 = quantize<int8_t>(y);
+        const Quantized<int16_t> qx16 = quantize<int16_t>(x), qy16 = quantize<int16_t>(y);
+        dequantize(restored, qx8);
+        for (size_t i = 0; i < n; ++i)
+            ASSERT_TRUE_MSG(fabs(restored[i] - x[i]) <= qx8.scale * 0.5 + EPS, "Quantize int8 round trip")
+        dequantize(restored, qx16);
+        for (size_t i = 0; i < n; ++i)
+            ASSERT_TRUE_MSG(fabs(restored[i] - x[i]) <= qx16.scale * 0.5 + EPS, "Quantize int16 round trip")
+
+        // |(x + dx)(y + dy) - xy| with |x|, |y| <= 10 and |dx| <= scale / 2
+        const double exact = x * y;
+        const double bound8 = n * (5 * (qx8.scale + qy8.scale) + qx8.scale * qy8.scale) + EPS;
+        const double bound16 = n * (5 * (qx16.scale + qy16.scale) + qx16.scale * qy16.scale) + EPS;
+        const double dot8 = qx8 * qy8, dot16 = qx16 * qy16;
+        ASSERT_TRUE_MSG(fabs(dot8 - exact) <= bound8, "Quantized dot int8")
+        ASSERT_TRUE_MSG(fabs(dot16 - exact) <= bound16, "Quantized dot int16")
+    }
+
+    {
+        // int8 int32 accumulators are flushed before overflowing
+        const size_t n = (size_t(1) << 21) + 7;
+        const std::vector<int8_t> a(n, int8_t(-128));
+        for (auto isa : {simd::Isa::Generic, simd::Isa::Sse2, simd::Isa::Avx2}) {
+            if (!simd::supported(isa))
+                continue;
+            ASSERT_TRUE_MSG(simd::dot(a.data(), a.data(), n, isa) == int64_t(n) * 16384, "SIMD dot int8 long")
+        }
+    }
+
     REPEAT(100)
     {
         std::vector<double> vec, vec2;